@@ -0,0 +1,317 @@
+#include "asset_archive.hpp"
+#include "asset_registry.hpp"
+#include "lz4.hpp"
+
+//std
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+//posix
+#include <sys/stat.h>
+
+static const uint32_t ARCHIVE_MAGIC = 0x52414b56; // "VKAR"
+static const uint32_t ARCHIVE_VERSION = 1;
+static const uint64_t ENTRY_ALIGNMENT = 16;
+
+enum ArchiveCompression : uint32_t
+{
+    ARCHIVE_STORED = 0,
+    ARCHIVE_LZ4 = 1
+};
+
+struct ArchiveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t nameBytes;
+};
+
+struct ArchiveEntry
+{
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    uint64_t hash;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t compression;
+    uint32_t reserved;
+};
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::string MyAssetArchive::entryName(const std::string& path)
+{
+    std::filesystem::path name = std::filesystem::path(path).lexically_normal();
+    // the asset loader asks with absolute paths
+    if (name.is_absolute()) {
+        std::error_code error;
+        std::filesystem::path base = std::filesystem::current_path(error);
+        if (!error)
+            name = name.lexically_relative(base);
+    }
+    return name.generic_string();
+}
+
+MyAssetArchive::MyAssetArchive(const std::string& path)
+    : file(path)
+{
+    if (file.size() < sizeof(ArchiveHeader)) {
+        throw std::runtime_error("failed to read asset archive header!");
+    }
+    header = reinterpret_cast<const ArchiveHeader*>(file.data());
+    if (header->magic != ARCHIVE_MAGIC || header->version != ARCHIVE_VERSION) {
+        throw std::runtime_error("file is not a supported asset archive!");
+    }
+    uint64_t indexEnd = sizeof(ArchiveHeader)
+        + static_cast<uint64_t>(header->entryCount) * sizeof(ArchiveEntry)
+        + header->nameBytes;
+    if (indexEnd > file.size()) {
+        throw std::runtime_error("asset archive index is truncated!");
+    }
+    entries = reinterpret_cast<const ArchiveEntry*>(file.data() + sizeof(ArchiveHeader));
+    names = reinterpret_cast<const char*>(entries + header->entryCount);
+
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        const ArchiveEntry& entry = entries[i];
+        if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header->nameBytes
+                || entry.offset + entry.storedSize > file.size()
+                || entry.compression > ARCHIVE_LZ4
+                || (entry.compression == ARCHIVE_STORED && entry.storedSize != entry.size))
+        {
+            throw std::runtime_error("asset archive entry out of bounds!");
+        }
+    }
+    // the index is all a lookup touches
+    file.adviseWillNeed(0, indexEnd);
+}
+
+MyAssetArchive::~MyAssetArchive()
+{ }
+
+std::string_view MyAssetArchive::getName(const ArchiveEntry& entry) const
+{
+    return std::string_view(names + entry.nameOffset, entry.nameLength);
+}
+
+const ArchiveEntry* MyAssetArchive::find(const std::string& path) const
+{
+    std::string name = entryName(path);
+    const ArchiveEntry* end = entries + header->entryCount;
+    const ArchiveEntry* entry = std::lower_bound(entries, end, std::string_view(name),
+            [this](const ArchiveEntry& e, std::string_view key) { return getName(e) < key; });
+    if (entry == end || getName(*entry) != name)
+        return nullptr;
+    return entry;
+}
+
+uint64_t MyAssetArchive::getSize(const ArchiveEntry& entry) const
+{
+    return entry.size;
+}
+
+uint64_t MyAssetArchive::getHash(const ArchiveEntry& entry) const
+{
+    return entry.hash;
+}
+
+MappedView MyAssetArchive::read(const ArchiveEntry& entry, std::vector<char>& buffer) const
+{
+    MappedView stored = file.view().subview(entry.offset, entry.storedSize);
+    if (entry.compression == ARCHIVE_STORED)
+        return stored;
+
+    buffer.resize(entry.size);
+    lz4Decompress(stored.data, stored.size, buffer.data(), buffer.size());
+    // the index is trusted for sizes, not for contents
+    if (hashAssetBytes(buffer.data(), buffer.size()) != entry.hash) {
+        throw std::runtime_error("asset archive entry " + std::string(getName(entry))
+                + " is corrupt!");
+    }
+    return {buffer.data(), buffer.size()};
+}
+
+void MyAssetArchive::adviseWillNeed(const ArchiveEntry& entry) const
+{
+    file.adviseWillNeed(entry.offset, entry.storedSize);
+}
+
+ArchiveStats MyAssetArchive::getStats() const
+{
+    ArchiveStats stats;
+    stats.entries = header->entryCount;
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        if (entries[i].compression != ARCHIVE_STORED)
+            stats.compressedEntries++;
+        stats.size += entries[i].size;
+        stats.storedSize += entries[i].storedSize;
+    }
+    return stats;
+}
+
+ArchiveStats MyAssetArchive::write(const std::string& path, const std::vector<ArchiveInput>& inputs)
+{
+    std::vector<ArchiveInput> sorted = inputs;
+    for (auto& input : sorted)
+        input.name = entryName(input.name);
+    std::sort(sorted.begin(), sorted.end(), [](const ArchiveInput& a, const ArchiveInput& b) {
+        return a.name < b.name;
+    });
+    for (size_t i = 1; i < sorted.size(); i++) {
+        if (sorted[i].name == sorted[i - 1].name) {
+            throw std::runtime_error("asset archive input " + sorted[i].name + " given twice!");
+        }
+    }
+
+    ArchiveHeader header{};
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = static_cast<uint32_t>(sorted.size());
+    std::vector<ArchiveEntry> entries(sorted.size(), ArchiveEntry{});
+    std::string names;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        entries[i].nameOffset = static_cast<uint32_t>(names.size());
+        entries[i].nameLength = static_cast<uint32_t>(sorted[i].name.size());
+        names += sorted[i].name;
+    }
+    header.nameBytes = static_cast<uint32_t>(names.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("failed to create asset archive " + path + "!");
+    }
+    // the index goes in last, once the offsets are known
+    uint64_t offset = alignUp(sizeof(header) + entries.size() * sizeof(ArchiveEntry)
+            + names.size(), ENTRY_ALIGNMENT);
+    out.seekp(static_cast<std::streamoff>(offset));
+
+    ArchiveStats stats;
+    stats.entries = sorted.size();
+    for (size_t i = 0; i < sorted.size(); i++) {
+        MyMappedFile source(sorted[i].sourcePath);
+        source.adviseSequential();
+        ArchiveEntry& entry = entries[i];
+        entry.offset = offset;
+        entry.size = source.size();
+        entry.hash = hashAssetBytes(source.data(), source.size());
+        entry.compression = ARCHIVE_STORED;
+
+        MappedView data = source.view();
+        std::vector<char> compressed;
+        if (sorted[i].compress) {
+            compressed = lz4Compress(source.data(), source.size());
+            if (compressed.size() < source.size()) {
+                entry.compression = ARCHIVE_LZ4;
+                data = {compressed.data(), compressed.size()};
+                stats.compressedEntries++;
+            }
+        }
+        entry.storedSize = data.size;
+        out.write(data.data, static_cast<std::streamsize>(data.size));
+        uint64_t next = alignUp(offset + data.size, ENTRY_ALIGNMENT);
+        for (uint64_t padding = offset + data.size; padding < next; padding++)
+            out.put('\0');
+        offset = next;
+        stats.size += entry.size;
+        stats.storedSize += entry.storedSize;
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()),
+            static_cast<std::streamsize>(entries.size() * sizeof(ArchiveEntry)));
+    out.write(names.data(), static_cast<std::streamsize>(names.size()));
+    if (!out) {
+        throw std::runtime_error("failed to write asset archive " + path + "!");
+    }
+    return stats;
+}
+
+static std::unique_ptr<MyAssetArchive> mountedArchive;
+
+void mountAssetArchive(const std::string& path)
+{
+    mountedArchive = std::make_unique<MyAssetArchive>(path);
+}
+
+const MyAssetArchive* getAssetArchive()
+{
+    return mountedArchive.get();
+}
+
+MyAssetFile::MyAssetFile(const std::string& path)
+{
+    const MyAssetArchive* archive = getAssetArchive();
+    const ArchiveEntry* entry = archive ? archive->find(path) : nullptr;
+    if (entry) {
+        archiveEntry = entry;
+        contents = archive->read(*entry, buffer);
+        return;
+    }
+    looseFile = std::make_unique<MyMappedFile>(path);
+    contents = looseFile->view();
+}
+
+const char* MyAssetFile::data() const
+{
+    return contents.data;
+}
+
+size_t MyAssetFile::size() const
+{
+    return contents.size;
+}
+
+MappedView MyAssetFile::view() const
+{
+    return contents;
+}
+
+void MyAssetFile::adviseSequential() const
+{
+    if (looseFile)
+        looseFile->adviseSequential();
+}
+
+void MyAssetFile::adviseWillNeed() const
+{
+    if (looseFile)
+        looseFile->adviseWillNeed();
+    else if (buffer.empty())
+        getAssetArchive()->adviseWillNeed(*archiveEntry);
+}
+
+void MyAssetFile::release(size_t offset, size_t length) const
+{
+    if (looseFile)
+        looseFile->release(offset, length);
+}
+
+bool MyAssetFile::exists(const std::string& path)
+{
+    const MyAssetArchive* archive = getAssetArchive();
+    if (archive && archive->find(path))
+        return true;
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+uint64_t MyAssetFile::getSize(const std::string& path)
+{
+    const MyAssetArchive* archive = getAssetArchive();
+    const ArchiveEntry* entry = archive ? archive->find(path) : nullptr;
+    if (entry)
+        return archive->getSize(*entry);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("failed to stat file " + path + "!");
+    }
+    return static_cast<uint64_t>(st.st_size);
+}
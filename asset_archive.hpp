@@ -0,0 +1,109 @@
+#pragma once
+
+#include "mapped_file.hpp"
+
+//std
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+
+struct ArchiveHeader;
+struct ArchiveEntry;
+
+// a file to put into an archive
+struct ArchiveInput
+{
+    std::string name;       // path the runtime asks for, relative to the working directory
+    std::string sourcePath; // where the data is read from now
+    bool compress = false;  // lz4, kept only if it makes the entry smaller
+};
+
+struct ArchiveStats
+{
+    size_t entries = 0;
+    size_t compressedEntries = 0;
+    uint64_t size = 0;       // of the entries as files
+    uint64_t storedSize = 0; // in the archive
+};
+
+/* * *
+ * Single file holding many assets. A header and an index sorted by path,
+ * with offset, stored size, size and content hash of each entry, are
+ * followed by the paths and the data, every entry 16 byte aligned. The
+ * archive is mapped once; stored entries are read straight from that
+ * mapping, lz4 compressed ones are decompressed on open.
+ *
+ * The hash is the one of hashAssetBytes over the uncompressed data, so
+ * asset deduplication needs no read of archived files.
+ */
+class MyAssetArchive
+{
+public:
+    MyAssetArchive(const std::string& path);
+    ~MyAssetArchive();
+
+    MyAssetArchive(const MyAssetArchive& other) = delete;
+    MyAssetArchive& operator=(const MyAssetArchive& other) = delete;
+
+    // nullptr if the archive has no entry for path
+    const ArchiveEntry* find(const std::string& path) const;
+    uint64_t getSize(const ArchiveEntry& entry) const;
+    uint64_t getHash(const ArchiveEntry& entry) const;
+    // the data of a stored entry, or decompressed into buffer
+    MappedView read(const ArchiveEntry& entry, std::vector<char>& buffer) const;
+    void adviseWillNeed(const ArchiveEntry& entry) const;
+    ArchiveStats getStats() const;
+
+    static ArchiveStats write(const std::string& path, const std::vector<ArchiveInput>& inputs);
+    // the name an archive stores path under
+    static std::string entryName(const std::string& path);
+
+private:
+    std::string_view getName(const ArchiveEntry& entry) const;
+
+    MyMappedFile file;
+    const ArchiveHeader* header;
+    const ArchiveEntry* entries;
+    const char* names;
+};
+
+// main thread, before any asset is opened. Loaders look there first
+void mountAssetArchive(const std::string& path);
+// nullptr without a mounted archive
+const MyAssetArchive* getAssetArchive();
+
+/* * *
+ * An asset file by path: the entry of the mounted archive if it has one,
+ * the loose file otherwise. Stored entries and loose files are mapped,
+ * compressed entries are decompressed into memory of their own.
+ */
+class MyAssetFile
+{
+public:
+    MyAssetFile(const std::string& path);
+
+    MyAssetFile(const MyAssetFile& other) = delete;
+    MyAssetFile& operator=(const MyAssetFile& other) = delete;
+
+    const char* data() const;
+    size_t size() const;
+    MappedView view() const;
+
+    // as MyMappedFile, only for mapped data
+    void adviseSequential() const;
+    void adviseWillNeed() const;
+    // as MyMappedFile, only for loose files, the archive keeps its pages
+    void release(size_t offset, size_t length) const;
+
+    static bool exists(const std::string& path);
+    // throws if neither the archive nor the disk has path
+    static uint64_t getSize(const std::string& path);
+
+private:
+    std::unique_ptr<MyMappedFile> looseFile;
+    const ArchiveEntry* archiveEntry = nullptr;
+    std::vector<char> buffer;
+    MappedView contents;
+};
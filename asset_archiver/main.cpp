@@ -0,0 +1,51 @@
+#include "../asset_archive.hpp"
+
+//std
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+
+/* * *
+ * Packs loose asset files into one archive MyAssetArchive maps at startup.
+ *
+ *   asset_archiver <output> [--lz4] <file>...
+ *
+ * Files are stored under the path given, which is the path the runtime
+ * asks for, so run it from the directory the application runs in. With
+ * --lz4 every entry that gets smaller is stored compressed.
+ */
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <output> [--lz4] <file>...\n";
+        return EXIT_FAILURE;
+    }
+    bool compress = false;
+    std::vector<ArchiveInput> inputs;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--lz4") == 0) {
+            compress = true;
+            continue;
+        }
+        ArchiveInput input;
+        input.name = argv[i];
+        input.sourcePath = argv[i];
+        inputs.push_back(std::move(input));
+    }
+    for (auto& input : inputs)
+        input.compress = compress;
+
+    try {
+        ArchiveStats stats = MyAssetArchive::write(argv[1], inputs);
+        std::cout << argv[1] << ": " << stats.entries << " files, "
+            << stats.compressedEntries << " compressed, " << stats.size << " -> "
+            << stats.storedSize << " bytes\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
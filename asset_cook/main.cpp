@@ -0,0 +1,148 @@
+#include "../asset_manifest.hpp"
+#include "../asset_registry.hpp"
+#include "../asset_archive.hpp"
+#include "../model.hpp"
+#include "../texture.hpp"
+#include "../mip_builder.hpp"
+#include "../thread_pool.hpp"
+#include "../texture_encoder/bc_encoder.hpp"
+#include "../texture_encoder/ktx2_writer.hpp"
+
+//std
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <stdexcept>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+/* * *
+ * Offline asset cooking: turns source assets into what the runtime loads
+ * without further processing and records them in <output>/manifest.txt.
+ *
+ *   asset_cook <output> <source>...
+ *
+ * OBJ models become mesh caches (optimized, with LODs and meshlets), images
+ * become BC7 KTX2 files with a Kaiser filtered mip chain. Each output goes to
+ * <output>/<source path> plus its extension. A source is only cooked again
+ * when its content hash differs from the one in the previous manifest, its
+ * output is gone or COOK_VERSION changed. The runtime ignores entries whose
+ * source changed size or modification time since. Run it from the directory
+ * the application runs in, the manifest records sources by the path given.
+ */
+
+// bump when the cooked output of a source changes
+static const uint32_t COOK_VERSION = 1;
+
+static bool endsWith(const std::string& value, const std::string& suffix)
+{
+    return value.size() >= suffix.size()
+        && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static void cookModel(const std::string& source, const std::string& output)
+{
+    MyModel model;
+    model.build(source.c_str());
+    if (!model.writeCachedModel(source.c_str(), output)) {
+        throw std::runtime_error("failed to write " + output + "!");
+    }
+}
+
+static void cookTexture(const std::string& source, const std::string& output)
+{
+    TextureImage image = MyTexture::decode(source.c_str(), false);
+    // the pool already runs one cook per thread
+    buildMipChain(image, MipFilter::Kaiser, 1);
+    writeKtx2(output.c_str(), compressImage(image, VK_FORMAT_BC7_SRGB_BLOCK));
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <output> <source>...\n";
+        return EXIT_FAILURE;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    std::filesystem::path outputDir = argv[1];
+    std::string manifestPath = (outputDir / "manifest.txt").string();
+
+    MyAssetManifest previous(COOK_VERSION);
+    if (std::filesystem::exists(manifestPath)) {
+        try {
+            previous = MyAssetManifest(manifestPath);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << ", cooking everything\n";
+        }
+    }
+    bool versionChanged = previous.getCookVersion() != COOK_VERSION;
+
+    MyAssetManifest manifest(COOK_VERSION);
+    std::vector<ManifestEntry> pending;
+    size_t skipped = 0;
+    try {
+        for (int i = 2; i < argc; i++) {
+            std::string source = argv[i];
+            std::string extension = endsWith(source, ".obj") ? ".meshcache" : ".ktx2";
+            ManifestEntry entry;
+            entry.source = MyAssetArchive::entryName(source);
+            entry.cooked = (outputDir / (entry.source + extension)).generic_string();
+            entry.sourceHash = hashAssetFile(source);
+            if (!statAssetFile(source, entry.sourceSize, entry.sourceMtime)) {
+                throw std::runtime_error("failed to stat " + source + "!");
+            }
+
+            const ManifestEntry* cooked = previous.find(source);
+            if (!versionChanged && cooked && cooked->sourceHash == entry.sourceHash
+                    && cooked->cooked == entry.cooked && std::filesystem::exists(entry.cooked)) {
+                manifest.set(std::move(entry));
+                skipped++;
+                continue;
+            }
+            pending.push_back(std::move(entry));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::mutex manifestMutex;
+    std::atomic<size_t> failed{0};
+    {
+        MyThreadPool pool;
+        for (const ManifestEntry& entry : pending) {
+            pool.submit([&entry, &manifest, &manifestMutex, &failed]() {
+                try {
+                    std::filesystem::create_directories(
+                            std::filesystem::path(entry.cooked).parent_path());
+                    if (endsWith(entry.cooked, ".meshcache"))
+                        cookModel(entry.source, entry.cooked);
+                    else
+                        cookTexture(entry.source, entry.cooked);
+                    std::lock_guard<std::mutex> lock(manifestMutex);
+                    manifest.set(entry);
+                } catch (const std::exception& e) {
+                    std::cerr << entry.source << ": " << e.what() << "\n";
+                    failed++;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    // sources that failed are left out, the runtime loads those uncooked
+    try {
+        manifest.write(manifestPath);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    float time = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << manifestPath << ": " << pending.size() - failed << " cooked, " << skipped
+        << " up to date, " << failed << " failed in " << time << " ms\n";
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
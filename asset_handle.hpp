@@ -0,0 +1,53 @@
+#pragma once
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <memory>
+
+template<typename T>
+struct AssetSlot
+{
+    std::shared_ptr<T> asset; // set on the main thread once the upload completed
+    std::shared_ptr<T> placeholder;
+    VkDeviceSize residentBytes = 0; // uploaded bytes, set with asset
+    bool failed = false;
+};
+
+/* * *
+ * Reference to an asset that may still be loading. Dereferencing gives the
+ * placeholder until the loader swaps the real asset in. That only happens
+ * in MyAssetLoader::update on the main thread, so it never changes while a
+ * frame is being recorded.
+ */
+template<typename T>
+class MyAssetHandle
+{
+public:
+    MyAssetHandle() = default;
+    // an asset that is resident already
+    MyAssetHandle(std::shared_ptr<T> asset)
+        : slot(std::make_shared<AssetSlot<T>>())
+    {
+        slot->asset = std::move(asset);
+    }
+    MyAssetHandle(std::shared_ptr<AssetSlot<T>> slot)
+        : slot(std::move(slot))
+    { }
+
+    bool isReady() const { return slot && slot->asset; }
+    explicit operator bool() const { return get() != nullptr; }
+
+    T* get() const
+    {
+        if (!slot)
+            return nullptr;
+        return slot->asset ? slot->asset.get() : slot->placeholder.get();
+    }
+    T* operator->() const { return get(); }
+    T& operator*() const { return *get(); }
+
+private:
+    std::shared_ptr<AssetSlot<T>> slot;
+};
@@ -0,0 +1,380 @@
+#include "asset_loader.hpp"
+#include "device.hpp"
+#include "model.hpp"
+#include "vertex.hpp"
+#include "geometry_store.hpp"
+#include "descriptor_manager.hpp"
+#include "mip_builder.hpp"
+#include "texture_streamer.hpp"
+#include "ktx2.hpp"
+
+//std
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+// staging bytes recorded per frame, one asset always goes through
+static const VkDeviceSize UPLOAD_BYTES_PER_FRAME = 32 * 1024 * 1024;
+// a line per asset as it becomes resident, the totals are in getStats
+static const bool LOG_ASSET_LOADS = false;
+
+MyAssetLoader::MyAssetLoader(MyDevice& device,
+        MyGeometryStore& geometry,
+        MyDescriptorManager& descriptorManager,
+        MyTextureStreamer* streamer,
+        unsigned threadCount)
+    : device(device),
+      geometry(geometry),
+      descriptorManager(descriptorManager),
+      streamer(streamer),
+      uploadScheduler(device.getUploadScheduler()),
+      workers(threadCount)
+{
+    compressedTextures = device.getCapabilities().features.textureCompressionBC == VK_TRUE;
+    mipGeneration = MyTexture::chooseMipGeneration(device);
+    createPlaceholders();
+}
+
+MyAssetLoader::~MyAssetLoader()
+{
+    workers.wait();
+    // recorded commands still reference the textures and geometry ranges
+    uploadScheduler.waitIdle();
+}
+
+void MyAssetLoader::createPlaceholders()
+{
+    // unit cube, faces wound counter clockwise seen from outside
+    const glm::vec3 faces[6][3] = {
+        {{ 1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}},
+        {{-1.f, 0.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 1.f, 0.f}},
+        {{0.f,  1.f, 0.f}, {0.f, 0.f, 1.f}, {1.f, 0.f, 0.f}},
+        {{0.f, -1.f, 0.f}, {1.f, 0.f, 0.f}, {0.f, 0.f, 1.f}},
+        {{0.f, 0.f,  1.f}, {1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+        {{0.f, 0.f, -1.f}, {0.f, 1.f, 0.f}, {1.f, 0.f, 0.f}},
+    };
+    const glm::vec2 corners[4] = {{-1.f, -1.f}, {1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}};
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (const auto& face : faces) {
+        uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (const auto& corner : corners) {
+            Vertex vertex{};
+            vertex.pos = 0.5f * (face[0] + corner.x * face[1] + corner.y * face[2]);
+            vertex.color = glm::vec3(1.f);
+            vertex.texCoord = {(corner.x + 1.f) * 0.5f, (corner.y + 1.f) * 0.5f};
+            vertices.push_back(vertex);
+        }
+        for (uint32_t index : {0u, 1u, 2u, 2u, 3u, 0u})
+            indices.push_back(base + index);
+    }
+    placeholderModel = std::make_shared<MyModel>(geometry, std::move(vertices), std::move(indices));
+
+    TextureImage checker;
+    checker.width = 4;
+    checker.height = 4;
+    for (uint32_t y = 0; y < checker.height; y++) {
+        for (uint32_t x = 0; x < checker.width; x++) {
+            uint8_t shade = ((x + y) & 1) ? 96 : 160;
+            checker.pixels.insert(checker.pixels.end(), {shade, shade, shade, 255});
+        }
+    }
+    placeholderTexture = std::make_shared<MyTexture>(device, checker);
+    descriptorManager.createTextureDescriptorSet(*placeholderTexture);
+}
+
+MyAssetHandle<MyModel> MyAssetLoader::loadModel(const std::string& path)
+{
+    std::string key = normalizeAssetPath(path);
+    if (auto slot = modelRegistry.findPath(key))
+        return MyAssetHandle<MyModel>(slot);
+
+    auto slot = std::make_shared<AssetSlot<MyModel>>();
+    slot->placeholder = placeholderModel;
+    modelRegistry.addPath(key, slot);
+
+    Decoded job;
+    job.path = path;
+    job.requested = std::chrono::high_resolution_clock::now();
+    job.modelSlot = slot;
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoding++;
+    }
+
+    // the job owns its state until it lands in the decoded queue
+    auto shared = std::make_shared<Decoded>(std::move(job));
+    workers.submit([this, shared]() {
+        try {
+            auto source = modelRegistry.claimContent(hashAssetFile(shared->path),
+                    shared->modelSlot);
+            if (source != shared->modelSlot) {
+                shared->modelSource = source;
+            }
+            else {
+                shared->model = std::make_shared<MyModel>(geometry);
+                shared->model->decode(shared->path.c_str());
+            }
+        } catch (const std::exception& e) {
+            shared->model.reset();
+            shared->error = e.what();
+        }
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoded.push_back(std::move(*shared));
+        decoding--;
+    });
+    return MyAssetHandle<MyModel>(slot);
+}
+
+MyAssetHandle<MyTexture> MyAssetLoader::loadTexture(const std::string& path)
+{
+    std::string key = normalizeAssetPath(path);
+    if (auto slot = textureRegistry.findPath(key))
+        return MyAssetHandle<MyTexture>(slot);
+
+    auto slot = std::make_shared<AssetSlot<MyTexture>>();
+    slot->placeholder = placeholderTexture;
+    textureRegistry.addPath(key, slot);
+
+    Decoded job;
+    job.path = path;
+    job.requested = std::chrono::high_resolution_clock::now();
+    job.textureSlot = slot;
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoding++;
+    }
+
+    auto shared = std::make_shared<Decoded>(std::move(job));
+    workers.submit([this, shared]() {
+        try {
+            auto source = textureRegistry.claimContent(hashAssetFile(shared->path),
+                    shared->textureSlot);
+            if (source != shared->textureSlot)
+                shared->textureSource = source;
+            else {
+                shared->levelPath = MyTexture::findKtx2(shared->path.c_str(), compressedTextures);
+                shared->image = std::make_unique<TextureImage>(shared->levelPath.empty()
+                        ? MyTexture::decode(shared->path.c_str(), compressedTextures)
+                        : loadKtx2(shared->levelPath.c_str()));
+                // the other workers decode other assets, build on this thread
+                if (shared->image->levels.empty() && mipGeneration == MipGeneration::Cpu)
+                    buildMipChain(*shared->image, MipFilter::Kaiser, 1);
+            }
+        } catch (const std::exception& e) {
+            shared->error = e.what();
+        }
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoded.push_back(std::move(*shared));
+        decoding--;
+    });
+    return MyAssetHandle<MyTexture>(slot);
+}
+
+void MyAssetLoader::update()
+{
+    for (size_t i = 0; i < uploads.size();) {
+        if (!uploadScheduler.isComplete(uploads[i].token)) {
+            i++;
+            continue;
+        }
+        retireUpload(uploads[i]);
+        uploads.erase(uploads.begin() + i);
+    }
+    for (size_t i = 0; i < sharedContent.size();) {
+        if (!resolveShared(sharedContent[i])) {
+            i++;
+            continue;
+        }
+        sharedContent.erase(sharedContent.begin() + i);
+    }
+
+    VkDeviceSize budget = UPLOAD_BYTES_PER_FRAME;
+    bool first = true;
+    while (true) {
+        Decoded next;
+        {
+            std::lock_guard<std::mutex> lock(decodedMutex);
+            if (decoded.empty())
+                break;
+            VkDeviceSize size = getUploadSize(decoded.front());
+            if (!first && size > budget)
+                break;
+            budget -= std::min(size, budget);
+            next = std::move(decoded.front());
+            decoded.pop_front();
+        }
+        first = false;
+
+        if (!next.error.empty()) {
+            std::cerr << "failed to load asset " << next.path << ": " << next.error << "\n";
+            markFailed(next);
+            continue;
+        }
+        if (next.modelSource || next.textureSource) {
+            if (!resolveShared(next))
+                sharedContent.push_back(std::move(next));
+            continue;
+        }
+        try {
+            recordUpload(next);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "failed to upload asset: " << e.what() << "\n";
+            markFailed(next);
+        }
+    }
+    // everything recorded this frame goes out in one batch
+    uploadScheduler.flush();
+}
+
+AssetLoaderStats MyAssetLoader::getStats()
+{
+    AssetLoaderStats stats = loadTotals;
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        stats.decoding = decoding;
+        stats.waiting = decoded.size();
+    }
+    stats.uploading = uploads.size();
+    stats.completed = completed;
+    stats.failed = failed;
+    stats.models = modelRegistry.getStats();
+    stats.textures = textureRegistry.getStats();
+    return stats;
+}
+
+VkDeviceSize MyAssetLoader::getUploadSize(const Decoded& decoded) const
+{
+    if (decoded.model)
+        return decoded.model->getUploadSize();
+    if (decoded.image)
+        return MyTexture::getUploadSize(*decoded.image);
+    return 0;
+}
+
+void MyAssetLoader::recordUpload(Decoded& decoded)
+{
+    Upload upload;
+    upload.bytes = getUploadSize(decoded);
+    if (decoded.model) {
+        decoded.model->recordUpload(uploadScheduler);
+    }
+    else {
+        upload.texture = std::make_shared<MyTexture>(device);
+        uint32_t baseLevel = streamer && !decoded.levelPath.empty()
+            ? MyTextureStreamer::getInitialLevel(*decoded.image) : 0;
+        upload.texture->recordUpload(*decoded.image, uploadScheduler, baseLevel);
+    }
+    // read after recording, staging may have flushed the batch before
+    upload.token = uploadScheduler.getPendingToken();
+    upload.decoded = std::move(decoded);
+    uploads.push_back(std::move(upload));
+}
+
+void MyAssetLoader::retireUpload(Upload& upload)
+{
+    Decoded& decoded = upload.decoded;
+    if (decoded.model) {
+        decoded.model->releaseCpuData();
+        decoded.modelSlot->residentBytes = upload.bytes;
+        decoded.modelSlot->asset = decoded.model;
+    }
+    else {
+        descriptorManager.createTextureDescriptorSet(*upload.texture);
+        decoded.textureSlot->residentBytes = upload.texture->getMemorySize();
+        decoded.textureSlot->asset = upload.texture;
+    }
+    completed++;
+
+    float time = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - decoded.requested).count();
+    loadTotals.loaded++;
+    loadTotals.readyTime += time;
+    loadTotals.maxReadyTime = std::max(loadTotals.maxReadyTime, time);
+    if (decoded.model) {
+        const ModelLoadStats& modelStats = decoded.model->getLoadStats();
+        switch (modelStats.source) {
+            case ModelSource::Cooked:    loadTotals.cookedModels++; break;
+            case ModelSource::MeshCache: loadTotals.warmModels++; break;
+            case ModelSource::Obj:       loadTotals.coldModels++; break;
+            case ModelSource::None:      break;
+        }
+        loadTotals.modelDecodeTime += modelStats.loadTime;
+    }
+    if (upload.texture) {
+        loadTotals.mipTime += upload.texture->getMipTime();
+        if (streamer && !decoded.levelPath.empty())
+            streamer->add(upload.texture, *decoded.image, decoded.levelPath);
+    }
+    if (!LOG_ASSET_LOADS)
+        return;
+
+    std::cout << "asset ready: " << decoded.path << " after " << time << " ms\n";
+    if (decoded.model) {
+        const ModelLoadStats& modelStats = decoded.model->getLoadStats();
+        std::cout << "model: " << getModelSourceName(modelStats.source) << ", "
+            << modelStats.vertices << " vertices, decoded in " << modelStats.loadTime << " ms\n";
+    }
+    if (upload.texture) {
+        std::cout << "texture: format " << upload.texture->getFormat() << ", "
+            << upload.texture->getMipLevels() << " levels, "
+            << upload.texture->getMemorySize() / 1024 << " KiB (RGBA8 with mips "
+            << MyTexture::getRgba8Size(decoded.image->width, decoded.image->height) / 1024
+            << " KiB)";
+        float mipTime = upload.texture->getMipTime();
+        if (mipTime > 0.f) {
+            std::cout << ", mips: " << (decoded.image->mipTime > 0.f ? "cpu " : "blit ")
+                << mipTime << " ms";
+        }
+        std::cout << "\n";
+    }
+}
+
+bool MyAssetLoader::resolveShared(Decoded& decoded)
+{
+    bool sourceFailed = false;
+    if (decoded.modelSource) {
+        if (decoded.modelSource->asset) {
+            decoded.modelSlot->residentBytes = decoded.modelSource->residentBytes;
+            decoded.modelSlot->asset = decoded.modelSource->asset;
+        }
+        else if (decoded.modelSource->failed) {
+            sourceFailed = true;
+        }
+        else {
+            return false;
+        }
+    }
+    else {
+        if (decoded.textureSource->asset) {
+            decoded.textureSlot->residentBytes = decoded.textureSource->residentBytes;
+            decoded.textureSlot->asset = decoded.textureSource->asset;
+        }
+        else if (decoded.textureSource->failed) {
+            sourceFailed = true;
+        }
+        else {
+            return false;
+        }
+    }
+
+    if (sourceFailed) {
+        std::cerr << "failed to load asset " << decoded.path << ": same content failed\n";
+        markFailed(decoded);
+        return true;
+    }
+    completed++;
+    if (LOG_ASSET_LOADS)
+        std::cout << "asset ready: " << decoded.path << " shared with identical content\n";
+    return true;
+}
+
+void MyAssetLoader::markFailed(Decoded& decoded)
+{
+    if (decoded.modelSlot)
+        decoded.modelSlot->failed = true;
+    if (decoded.textureSlot)
+        decoded.textureSlot->failed = true;
+    failed++;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include "texture.hpp"
+#include "upload_scheduler.hpp"
+#include "asset_handle.hpp"
+#include "asset_registry.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <memory>
+#include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+class MyDevice;
+class MyModel;
+class MyGeometryStore;
+class MyDescriptorManager;
+class MyTextureStreamer;
+
+struct AssetLoaderStats
+{
+    size_t decoding = 0;  // queued or running on a worker
+    size_t waiting = 0;   // decoded, waiting for upload budget
+    size_t uploading = 0; // recorded, batch not completed yet
+    size_t completed = 0;
+    size_t failed = 0;
+    // since creation, of assets that became resident
+    size_t loaded = 0;            // decoded and uploaded, not shared
+    size_t cookedModels = 0;
+    size_t warmModels = 0;        // from the mesh cache
+    size_t coldModels = 0;        // parsed and processed
+    float modelDecodeTime = 0.f;  // ms, summed over the workers
+    float mipTime = 0.f;          // ms, cpu or blit
+    float readyTime = 0.f;        // ms from request to resident, summed
+    float maxReadyTime = 0.f;
+    AssetRegistryStats models;
+    AssetRegistryStats textures;
+};
+
+/* * *
+ * Loads models and textures without blocking the frame. Requests for a
+ * file that is already loading or resident, by path or by content, share
+ * its slot instead of loading it again. Files are decoded
+ * on a worker pool. update() then records the uploads of whatever finished
+ * decoding, within a per frame byte budget, into the upload scheduler and
+ * flushes them as one batch. Assets are swapped into their handles once
+ * their batch has completed. Until then handles render a placeholder cube
+ * or a grey checker texture.
+ *
+ * With a streamer textures read from a .ktx2 only upload their coarse
+ * levels and are handed to it once resident, it reads the finer ones back
+ * from that file as they are needed. Other images upload every level.
+ */
+class MyAssetLoader
+{
+public:
+    MyAssetLoader(MyDevice& device,
+            MyGeometryStore& geometry,
+            MyDescriptorManager& descriptorManager,
+            MyTextureStreamer* streamer = nullptr,
+            unsigned threadCount = 0);
+    ~MyAssetLoader();
+
+    MyAssetLoader(const MyAssetLoader& other) = delete;
+    MyAssetLoader& operator=(const MyAssetLoader& other) = delete;
+
+    MyAssetHandle<MyModel> loadModel(const std::string& path);
+    MyAssetHandle<MyTexture> loadTexture(const std::string& path);
+
+    // main thread, once per frame
+    void update();
+
+    AssetLoaderStats getStats();
+
+private:
+    struct Decoded
+    {
+        std::string path;
+        std::chrono::high_resolution_clock::time_point requested;
+        std::shared_ptr<AssetSlot<MyModel>> modelSlot;
+        std::shared_ptr<MyModel> model;
+        std::shared_ptr<AssetSlot<MyTexture>> textureSlot;
+        std::unique_ptr<TextureImage> image;
+        std::string levelPath; // .ktx2 image was read from, empty for other images
+        // same content as an asset loaded through another path
+        std::shared_ptr<AssetSlot<MyModel>> modelSource;
+        std::shared_ptr<AssetSlot<MyTexture>> textureSource;
+        std::string error;
+    };
+
+    struct Upload
+    {
+        Decoded decoded;
+        std::shared_ptr<MyTexture> texture;
+        VkDeviceSize bytes = 0;
+        UploadToken token = 0;
+    };
+
+    void createPlaceholders();
+    VkDeviceSize getUploadSize(const Decoded& decoded) const;
+    void recordUpload(Decoded& decoded);
+    void retireUpload(Upload& upload);
+    // true once the source slot is resident or failed
+    bool resolveShared(Decoded& decoded);
+    void markFailed(Decoded& decoded);
+
+    MyDevice& device;
+    MyGeometryStore& geometry;
+    MyDescriptorManager& descriptorManager;
+    MyTextureStreamer* streamer;
+    MyUploadScheduler& uploadScheduler;
+    std::shared_ptr<MyModel> placeholderModel;
+    std::shared_ptr<MyTexture> placeholderTexture;
+
+    std::mutex decodedMutex;
+    std::deque<Decoded> decoded;
+    size_t decoding = 0;
+    std::vector<Upload> uploads;
+    std::vector<Decoded> sharedContent; // waiting for their source slot
+    bool compressedTextures = false;    // device samples BC formats
+    MipGeneration mipGeneration = MipGeneration::Blit;
+    size_t completed = 0;
+    size_t failed = 0;
+    AssetLoaderStats loadTotals; // the since creation counters only
+
+    MyAssetRegistry<MyModel> modelRegistry;
+    MyAssetRegistry<MyTexture> textureRegistry;
+
+    // last, joins before anything a job touches goes away
+    MyThreadPool workers;
+};
@@ -0,0 +1,125 @@
+#include "asset_manifest.hpp"
+#include "asset_archive.hpp"
+#include "asset_registry.hpp"
+
+//std
+#include <stdexcept>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <vector>
+#include <cstdio>
+
+static const char* MANIFEST_MAGIC = "asset-manifest";
+static const uint32_t MANIFEST_VERSION = 2;
+
+MyAssetManifest::MyAssetManifest(uint32_t cookVersion)
+    : cookVersion(cookVersion)
+{ }
+
+MyAssetManifest::MyAssetManifest(const std::string& path)
+{
+    MyAssetFile file(path);
+    MappedStreamBuffer buffer(file.view());
+    std::istream in(&buffer);
+
+    std::string magic;
+    uint32_t version = 0;
+    in >> magic >> version >> cookVersion;
+    if (!in || magic != MANIFEST_MAGIC || version != MANIFEST_VERSION) {
+        throw std::runtime_error("file is not a supported asset manifest!");
+    }
+    in.ignore(1);
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty())
+            continue;
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (size_t tab = line.find('\t'); tab != std::string::npos; tab = line.find('\t', start)) {
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        fields.push_back(line.substr(start));
+        if (fields.size() != 5) {
+            throw std::runtime_error("malformed asset manifest entry in " + path + "!");
+        }
+        ManifestEntry entry;
+        entry.sourceHash = std::stoull(fields[0], nullptr, 16);
+        entry.sourceSize = std::stoull(fields[1]);
+        entry.sourceMtime = std::stoll(fields[2]);
+        entry.source = fields[3];
+        entry.cooked = fields[4];
+        set(std::move(entry));
+    }
+}
+
+const ManifestEntry* MyAssetManifest::find(const std::string& source) const
+{
+    auto entry = entries.find(MyAssetArchive::entryName(source));
+    return entry == entries.end() ? nullptr : &entry->second;
+}
+
+void MyAssetManifest::set(ManifestEntry entry)
+{
+    entry.source = MyAssetArchive::entryName(entry.source);
+    std::string key = entry.source;
+    entries[key] = std::move(entry);
+}
+
+void MyAssetManifest::write(const std::string& path) const
+{
+    // complete or not there, a reader never sees half a manifest
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("failed to create asset manifest " + path + "!");
+        }
+        out << MANIFEST_MAGIC << " " << MANIFEST_VERSION << " " << cookVersion << "\n";
+        for (const auto& [source, entry] : entries) {
+            out << std::hex << entry.sourceHash << std::dec << "\t" << entry.sourceSize
+                << "\t" << entry.sourceMtime << "\t" << entry.source << "\t" << entry.cooked << "\n";
+        }
+        if (!out) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("failed to write asset manifest " + path + "!");
+        }
+    }
+    std::rename(tmpPath.c_str(), path.c_str());
+}
+
+uint32_t MyAssetManifest::getCookVersion() const
+{
+    return cookVersion;
+}
+
+size_t MyAssetManifest::size() const
+{
+    return entries.size();
+}
+
+static std::unique_ptr<MyAssetManifest> loadedManifest;
+
+void loadAssetManifest(const std::string& path)
+{
+    loadedManifest = std::make_unique<MyAssetManifest>(path);
+}
+
+const ManifestEntry* findCookedAsset(const std::string& source)
+{
+    const ManifestEntry* entry = loadedManifest ? loadedManifest->find(source) : nullptr;
+    uint64_t size;
+    int64_t mtime;
+    // edited since the cook, the loaders fall back to the source
+    if (entry && statAssetFile(source, size, mtime)
+            && (size != entry->sourceSize || mtime != entry->sourceMtime))
+        return nullptr;
+    return entry;
+}
+
+size_t getCookedAssetCount()
+{
+    return loadedManifest ? loadedManifest->size() : 0;
+}
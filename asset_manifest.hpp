@@ -0,0 +1,55 @@
+#pragma once
+
+//std
+#include <string>
+#include <map>
+#include <cstdint>
+
+// a source asset and its runtime ready version
+struct ManifestEntry
+{
+    std::string source; // as the runtime asks for it
+    std::string cooked; // mesh cache for models, KTX2 for textures
+    uint64_t sourceHash = 0;
+    // of the source when it was cooked, see statAssetFile
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+};
+
+/* * *
+ * What asset_cook produced: for every cooked source its output and the
+ * content hash, size and modification time of the source it was cooked
+ * from. Loaders take the cooked file instead of the source when the
+ * manifest lists it, and the asset loader deduplicates by the recorded hash
+ * without reading the source.
+ *
+ * Text, a header line with the format and cook version and then one
+ * tab separated "hash size mtime source cooked" line per entry.
+ */
+class MyAssetManifest
+{
+public:
+    // empty
+    MyAssetManifest(uint32_t cookVersion = 0);
+    // through MyAssetFile, so it may be archived. Throws if unreadable
+    MyAssetManifest(const std::string& path);
+
+    const ManifestEntry* find(const std::string& source) const;
+    void set(ManifestEntry entry);
+    void write(const std::string& path) const;
+
+    uint32_t getCookVersion() const;
+    size_t size() const;
+
+private:
+    uint32_t cookVersion = 0;
+    std::map<std::string, ManifestEntry> entries;
+};
+
+// main thread, before any asset is opened
+void loadAssetManifest(const std::string& path);
+// nullptr without a loaded manifest or entry for source, or when the source
+// on disk differs in size or modification time from the one cooked. Sources
+// only in the asset archive are taken as cooked
+const ManifestEntry* findCookedAsset(const std::string& source);
+size_t getCookedAssetCount();
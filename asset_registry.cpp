@@ -0,0 +1,52 @@
+#include "asset_registry.hpp"
+#include "asset_archive.hpp"
+#include "asset_manifest.hpp"
+
+//std
+#include <filesystem>
+
+//posix
+#include <sys/stat.h>
+
+std::string normalizeAssetPath(const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    if (error)
+        canonical = std::filesystem::path(path).lexically_normal();
+    return canonical.generic_string();
+}
+
+uint64_t hashAssetFile(const std::string& path)
+{
+    if (const ManifestEntry* cooked = findCookedAsset(path))
+        return cooked->sourceHash;
+    const MyAssetArchive* archive = getAssetArchive();
+    const ArchiveEntry* entry = archive ? archive->find(path) : nullptr;
+    if (entry)
+        return archive->getHash(*entry);
+
+    MyMappedFile file(path);
+    file.adviseSequential();
+    return hashAssetBytes(file.data(), file.size());
+}
+
+bool statAssetFile(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+uint64_t hashAssetBytes(const char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "asset_handle.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <memory>
+#include <string>
+#include <map>
+#include <set>
+#include <mutex>
+#include <cstdint>
+
+struct AssetRegistryStats
+{
+    size_t hits = 0;        // requests served by an asset already loading or resident
+    size_t contentHits = 0; // hits on a different path with the same content
+    size_t misses = 0;
+    size_t entries = 0;     // paths with a live slot
+    VkDeviceSize residentBytes = 0;
+    // what every request loading its own copy would have cost on top
+    VkDeviceSize savedBytes = 0;
+};
+
+// the same file reached through different relative paths maps to one key
+std::string normalizeAssetPath(const std::string& path);
+// FNV-1a over the file contents, throws if the file can not be read.
+// Cooked and archived files use the hash recorded for them
+uint64_t hashAssetFile(const std::string& path);
+uint64_t hashAssetBytes(const char* data, size_t size);
+// size and modification time in ns of a file on disk, false if it is not
+// there. Cheap checks whether a source changed since something was made of it
+bool statAssetFile(const std::string& path, uint64_t& size, int64_t& mtime);
+
+/* * *
+ * Deduplicates loads of one asset type. Slots are found by normalized path
+ * on the requesting thread and by content hash once a worker has read the
+ * file. The registry only holds weak references, an asset goes away with
+ * its last handle and a later request loads it again.
+ */
+template<typename T>
+class MyAssetRegistry
+{
+public:
+    // slot already registered for path, counts the request
+    std::shared_ptr<AssetSlot<T>> findPath(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = paths.find(path);
+        if (it == paths.end())
+            return nullptr;
+        auto slot = it->second.slot.lock();
+        // a failed load is retried rather than handed out again
+        if (!slot || slot->failed) {
+            paths.erase(it);
+            return nullptr;
+        }
+        it->second.requests++;
+        stats.hits++;
+        return slot;
+    }
+
+    void addPath(const std::string& path, const std::shared_ptr<AssetSlot<T>>& slot)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        paths[path] = {slot, 1};
+        stats.misses++;
+    }
+
+    // register slot as the owner of the content, or return the live slot
+    // that already owns it
+    std::shared_ptr<AssetSlot<T>> claimContent(uint64_t hash,
+            const std::shared_ptr<AssetSlot<T>>& slot)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = contents.find(hash);
+        if (it != contents.end()) {
+            auto owner = it->second.lock();
+            if (owner && !owner->failed && owner != slot) {
+                // counted as a miss by addPath before the file was read
+                stats.contentHits++;
+                stats.hits++;
+                stats.misses--;
+                return owner;
+            }
+        }
+        contents[hash] = slot;
+        return slot;
+    }
+
+    AssetRegistryStats getStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        AssetRegistryStats current = stats;
+        std::set<const T*> counted;
+        VkDeviceSize requestedBytes = 0;
+        for (auto it = paths.begin(); it != paths.end();) {
+            auto slot = it->second.slot.lock();
+            if (!slot) {
+                it = paths.erase(it);
+                continue;
+            }
+            current.entries++;
+            if (slot->asset) {
+                requestedBytes += slot->residentBytes * it->second.requests;
+                if (counted.insert(slot->asset.get()).second)
+                    current.residentBytes += slot->residentBytes;
+            }
+            ++it;
+        }
+        for (auto it = contents.begin(); it != contents.end();) {
+            if (it->second.expired())
+                it = contents.erase(it);
+            else
+                ++it;
+        }
+        current.savedBytes = requestedBytes - current.residentBytes;
+        return current;
+    }
+
+private:
+    struct PathEntry
+    {
+        std::weak_ptr<AssetSlot<T>> slot;
+        size_t requests = 0;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, PathEntry> paths;
+    std::map<uint64_t, std::weak_ptr<AssetSlot<T>>> contents;
+    AssetRegistryStats stats;
+};
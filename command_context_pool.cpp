@@ -0,0 +1,200 @@
+#include "command_context_pool.hpp"
+#include "device.hpp"
+
+//std
+#include <stdexcept>
+#include <iostream>
+
+struct CommandPage
+{
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> buffers; // allocated so far, reused after a reset
+    uint32_t used = 0;                    // begun since the last reset
+    uint32_t returned = 0;                // of those, ended or recycled
+    std::vector<VkFence> fences;          // of ended buffers, not seen signalled yet
+};
+
+MyCommandContextPool::MyCommandContextPool(MyDevice& device)
+    : device(device)
+{ }
+
+MyCommandContextPool::~MyCommandContextPool()
+{
+    size_t pending = 0;
+    for (auto& [key, commands] : threads) {
+        for (auto& page : commands.pages) {
+            pending += page->used - page->returned;
+            for (VkFence fence : page->fences)
+                vkDestroyFence(device.device, fence, nullptr);
+            // frees its command buffers
+            vkDestroyCommandPool(device.device, page->pool, nullptr);
+        }
+    }
+    for (VkFence fence : freeFences)
+        vkDestroyFence(device.device, fence, nullptr);
+    if (pending > 0)
+        std::cerr << "command context pool destroyed with " << pending << " pending command buffers\n";
+}
+
+VkCommandBuffer MyCommandContextPool::begin(CommandPool pool)
+{
+    VkCommandBuffer commandBuffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [entry, inserted] = threads.try_emplace({std::this_thread::get_id(), pool});
+        if (inserted)
+            stats.threads++;
+        CommandPage* page = acquirePage(entry->second, pool);
+
+        if (page->used == page->buffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = page->pool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device.device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate single commands!");
+            }
+            page->buffers.push_back(commandBuffer);
+            stats.buffers++;
+        }
+        commandBuffer = page->buffers[page->used++];
+        owners[commandBuffer] = page;
+        stats.begins++;
+    }
+
+    // the pool is this thread's, recording needs no lock
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    return commandBuffer;
+}
+
+VkFence MyCommandContextPool::end(VkCommandBuffer commandBuffer)
+{
+    vkEndCommandBuffer(commandBuffer);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (owners.find(commandBuffer) == owners.end()) {
+        throw std::runtime_error("ended command buffer not begun by the command context pool!");
+    }
+    // the buffer stays pending until submitted or recycle, a failed submit
+    // must not leave its page waiting on a fence that never signals
+    return acquireFence();
+}
+
+void MyCommandContextPool::submitted(VkCommandBuffer commandBuffer, VkFence fence)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto owner = owners.find(commandBuffer);
+    if (owner == owners.end()) {
+        throw std::runtime_error("submitted command buffer not begun by the command context pool!");
+    }
+    owner->second->fences.push_back(fence);
+    owner->second->returned++;
+    owners.erase(owner);
+}
+
+void MyCommandContextPool::recycle(VkCommandBuffer commandBuffer, VkFence fence)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto owner = owners.find(commandBuffer);
+    if (owner == owners.end()) {
+        throw std::runtime_error("recycled command buffer not begun by the command context pool!");
+    }
+    if (fence != VK_NULL_HANDLE)
+        freeFences.push_back(fence);
+    owner->second->returned++;
+    owners.erase(owner);
+}
+
+CommandContextStats MyCommandContextPool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    CommandContextStats current = stats;
+    current.pending = owners.size();
+    return current;
+}
+
+CommandPage* MyCommandContextPool::acquirePage(ThreadCommands& commands, CommandPool pool)
+{
+    CommandPage* current = commands.current;
+    // start over at the front whenever everything recorded so far is done
+    if (current && current->used > 0 && isRetired(*current))
+        resetPage(*current);
+    if (current && current->used < PAGE_BUFFERS)
+        return current;
+
+    for (auto& page : commands.pages) {
+        if (page.get() != current && isRetired(*page)) {
+            resetPage(*page);
+            commands.current = page.get();
+            return commands.current;
+        }
+    }
+    commands.pages.push_back(createPage(pool));
+    commands.current = commands.pages.back().get();
+    return commands.current;
+}
+
+std::unique_ptr<CommandPage> MyCommandContextPool::createPage(CommandPool pool)
+{
+    const QueueFamilyIndices& queueFamilyIndices = device.getQueueFamilies();
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = pool == CommandPool::Transfer
+        ? queueFamilyIndices.transferFamily.value()
+        : queueFamilyIndices.graphicsFamily.value();
+    // buffers are only ever reset together with their pool
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    auto page = std::make_unique<CommandPage>();
+    if (vkCreateCommandPool(device.device, &poolInfo, nullptr, &page->pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create single commands pool!");
+    }
+    page->buffers.reserve(PAGE_BUFFERS);
+    stats.pools++;
+    return page;
+}
+
+bool MyCommandContextPool::isRetired(CommandPage& page)
+{
+    if (page.returned != page.used)
+        return false;
+    for (VkFence fence : page.fences) {
+        if (vkGetFenceStatus(device.device, fence) != VK_SUCCESS)
+            return false;
+    }
+    return true;
+}
+
+void MyCommandContextPool::resetPage(CommandPage& page)
+{
+    if (!page.fences.empty()) {
+        vkResetFences(device.device, static_cast<uint32_t>(page.fences.size()), page.fences.data());
+        freeFences.insert(freeFences.end(), page.fences.begin(), page.fences.end());
+        page.fences.clear();
+    }
+    vkResetCommandPool(device.device, page.pool, 0);
+    page.used = 0;
+    page.returned = 0;
+    stats.resets++;
+}
+
+VkFence MyCommandContextPool::acquireFence()
+{
+    if (!freeFences.empty()) {
+        VkFence fence = freeFences.back();
+        freeFences.pop_back();
+        return fence;
+    }
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence fence;
+    if (vkCreateFence(device.device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create single commands fence!");
+    }
+    return fence;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <cstdint>
+
+class MyDevice;
+struct CommandPage;
+
+// the queue family single commands are recorded for
+enum class CommandPool
+{
+    Command,
+    Transfer
+};
+
+struct CommandContextStats
+{
+    size_t threads = 0;     // thread and queue family pairs that began commands
+    size_t pools = 0;       // VkCommandPools, pages of PAGE_BUFFERS buffers
+    size_t buffers = 0;     // VkCommandBuffers allocated, never freed
+    size_t pending = 0;     // begun and not handed back or completed yet
+    uint64_t begins = 0;
+    uint64_t resets = 0;    // vkResetCommandPool calls
+};
+
+/* * *
+ * Transient command buffers for one time submissions. Every thread records
+ * into VkCommandPools of its own, so loader threads can record in parallel
+ * without locking a pool while they do. Command buffers are taken in order
+ * from the calling thread's current pool and are never freed: once all of
+ * a pool's buffers have been handed back and their fences have signalled,
+ * the whole pool is reset and its buffers are begun again. A pool that is
+ * still in use when it runs out of buffers is put aside for the next one.
+ *
+ * Record into and end a command buffer on the thread that began it. The
+ * pools of a thread live until the device is destroyed.
+ */
+class MyCommandContextPool
+{
+public:
+    static const uint32_t PAGE_BUFFERS = 16;
+
+    MyCommandContextPool(MyDevice& device);
+    ~MyCommandContextPool();
+
+    MyCommandContextPool(const MyCommandContextPool& other) = delete;
+    MyCommandContextPool& operator=(const MyCommandContextPool& other) = delete;
+
+    // begun with one time submit, for the queue family of pool
+    VkCommandBuffer begin(CommandPool pool);
+    // ends commandBuffer and returns the fence its submission has to signal.
+    // Hand both back with submitted once the submission succeeded, or with
+    // recycle if it failed
+    VkFence end(VkCommandBuffer commandBuffer);
+    // wait on fence before beginning another command buffer on this thread.
+    // Buffer and fence are reused once the fence has signalled
+    void submitted(VkCommandBuffer commandBuffer, VkFence fence);
+    // for command buffers ended and submitted by the caller, once they have
+    // completed, or never submitted at all. A fence from end that no
+    // submission was given is reused right away
+    void recycle(VkCommandBuffer commandBuffer, VkFence fence = VK_NULL_HANDLE);
+
+    CommandContextStats getStats() const;
+
+private:
+    struct ThreadCommands
+    {
+        std::vector<std::unique_ptr<CommandPage>> pages;
+        CommandPage* current = nullptr;
+    };
+
+    CommandPage* acquirePage(ThreadCommands& commands, CommandPool pool);
+    std::unique_ptr<CommandPage> createPage(CommandPool pool);
+    bool isRetired(CommandPage& page);
+    void resetPage(CommandPage& page);
+    VkFence acquireFence();
+
+    MyDevice& device;
+    std::map<std::pair<std::thread::id, CommandPool>, ThreadCommands> threads;
+    std::unordered_map<VkCommandBuffer, CommandPage*> owners;
+    std::vector<VkFence> freeFences;
+    CommandContextStats stats;
+    mutable std::mutex mutex;
+};
@@ -1,6 +1,7 @@
 #include "descriptor_manager.hpp"
 #include "device.hpp"
 #include "texture.hpp"
+#include "swapchain.hpp"
 
 #include <vulkan/vulkan.h>
 
@@ -8,6 +9,10 @@
 #include <stdexcept>
 #include <cstdint>
 #include <cassert>
+#include <algorithm>
+
+// a frame recorded in update n is done once update n + FRAME_DELAY starts
+static const uint64_t FRAME_DELAY = MySwapChain::MAX_FRAMES_IN_FLIGHT + 1;
 
 MyDescriptorManager::MyDescriptorManager(MyDevice& device)
     : device(device)
@@ -17,6 +22,8 @@ MyDescriptorManager::~MyDescriptorManager()
 {
     vkDestroyDescriptorSetLayout(device.device, globalDescriptorSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(device.device, textureDescriptorSetLayout, nullptr);
+    if (bindlessPool != VK_NULL_HANDLE)
+        vkDestroyDescriptorPool(device.device, bindlessPool, nullptr);
 }
 
 void MyDescriptorManager::createDescriptorSetsHelper(std::vector<VkDescriptorSet>& descriptorSets, 
@@ -41,6 +48,13 @@ void MyDescriptorManager::createDescriptorSets(uint32_t numFrameBuffers,
         std::vector<std::shared_ptr<MyTexture>>& textures)
 {
     createDescriptorSetsHelper(globalDescriptorSets, numFrameBuffers, globalDescriptorSetLayout);
+    if (isBindless()) {
+        for (auto& texture : textures) {
+            TextureBinding binding = allocateTextureBinding();
+            texture->setDescriptor(binding.descriptor, binding.index, this);
+        }
+        return;
+    }
     createDescriptorSetsHelper(textureDescriptorSets, 
             static_cast<uint32_t>(textures.size()), textureDescriptorSetLayout);
     for (size_t i = 0; i < textures.size(); i++) {
@@ -48,6 +62,11 @@ void MyDescriptorManager::createDescriptorSets(uint32_t numFrameBuffers,
     }
 }
 
+void MyDescriptorManager::createGlobalDescriptorSets(uint32_t numFrameBuffers)
+{
+    createDescriptorSetsHelper(globalDescriptorSets, numFrameBuffers, globalDescriptorSetLayout);
+}
+
 void MyDescriptorManager::updateGlobalDescriptorSets(size_t i,
         VkDescriptorBufferInfo& bufferInfo)
 {
@@ -74,6 +93,11 @@ void MyDescriptorManager::updateGlobalDescriptorSets(size_t i,
 void MyDescriptorManager::updateTextureDescriptorSets(
         std::vector<std::shared_ptr<MyTexture>>& textures)
 {
+    if (isBindless()) {
+        for (auto& texture : textures)
+            writeTextureBinding({texture->getDescriptor(), texture->getDescriptorIndex()}, *texture);
+        return;
+    }
     assert(textures.size() == textureDescriptorSets.size());
 
     std::vector<VkWriteDescriptorSet> descriptorWrites(textures.size(),
@@ -103,6 +127,82 @@ void MyDescriptorManager::updateTextureDescriptorSets(
             0, nullptr);
 }
 
+void MyDescriptorManager::createTextureDescriptorSet(MyTexture& texture)
+{
+    TextureBinding binding = allocateTextureBinding();
+    texture.setDescriptor(binding.descriptor, binding.index, this);
+    writeTextureBinding(binding, texture);
+}
+
+TextureBinding MyDescriptorManager::allocateTextureBinding()
+{
+    if (isBindless()) {
+        if (!freeBindlessSlots.empty()) {
+            uint32_t index = freeBindlessSlots.back();
+            freeBindlessSlots.pop_back();
+            return {bindlessSet, index};
+        }
+        if (bindlessNext == bindlessCapacity) {
+            throw std::runtime_error("failed to allocate bindless texture slot, table is full!");
+        }
+        return {bindlessSet, bindlessNext++};
+    }
+    std::vector<VkDescriptorSet> descriptorSets;
+    createDescriptorSetsHelper(descriptorSets, 1, textureDescriptorSetLayout);
+    return {descriptorSets[0], 0};
+}
+
+void MyDescriptorManager::freeTextureBinding(TextureBinding binding)
+{
+    if (binding.descriptor == VK_NULL_HANDLE)
+        return;
+    if (binding.descriptor == bindlessSet)
+        retiredBindlessSlots.push_back({binding.index, frame + FRAME_DELAY});
+    else
+        retiredTextureSets.push_back({binding.descriptor, frame + FRAME_DELAY});
+}
+
+void MyDescriptorManager::update()
+{
+    frame++;
+    auto reusable = std::partition(retiredBindlessSlots.begin(), retiredBindlessSlots.end(),
+            [this](const auto& retired) { return retired.second > frame; });
+    for (auto retired = reusable; retired != retiredBindlessSlots.end(); retired++)
+        freeBindlessSlots.push_back(retired->first);
+    retiredBindlessSlots.erase(reusable, retiredBindlessSlots.end());
+
+    auto freeable = std::partition(retiredTextureSets.begin(), retiredTextureSets.end(),
+            [this](const auto& retired) { return retired.second > frame; });
+    std::vector<VkDescriptorSet> sets;
+    for (auto retired = freeable; retired != retiredTextureSets.end(); retired++)
+        sets.push_back(retired->first);
+    retiredTextureSets.erase(freeable, retiredTextureSets.end());
+    if (!sets.empty())
+        vkFreeDescriptorSets(device.device, device.descriptorPool,
+                static_cast<uint32_t>(sets.size()), sets.data());
+}
+
+void MyDescriptorManager::writeTextureBinding(TextureBinding binding,
+        const MyTexture& texture)
+{
+    VkDescriptorImageInfo imageInfo = texture.getImageInfo();
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = binding.descriptor;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = binding.index;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo = nullptr;
+    descriptorWrite.pImageInfo = &imageInfo;
+    descriptorWrite.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(device.device, 
+            1,
+            &descriptorWrite,
+            0, nullptr);
+}
+
 void MyDescriptorManager::createDescriptorSetLayoutHelper(
     std::vector<VkDescriptorSetLayoutBinding> bindings,
     VkDescriptorSetLayout* layout)
@@ -131,6 +231,80 @@ void MyDescriptorManager::createTextureDescriptorSetLayout(
     createDescriptorSetLayoutHelper(bindings, &textureDescriptorSetLayout);
 }
 
+void MyDescriptorManager::createBindlessTextureTable(uint32_t capacity)
+{
+    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+    samplerLayoutBinding.binding = 0;
+    samplerLayoutBinding.descriptorCount = capacity;
+    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerLayoutBinding.pImmutableSamplers = nullptr;
+    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // slots are written while earlier frames still sample other slots,
+    // and slots no texture took yet are never read
+    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+        | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &samplerLayoutBinding;
+
+    if (vkCreateDescriptorSetLayout(device.device, &layoutInfo, nullptr,
+                &textureDescriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create bindless texture descriptor set layout!");
+    }
+
+    // update after bind sets need a pool of their own
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(device.device, &poolInfo, nullptr, &bindlessPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless texture descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = bindlessPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &textureDescriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device.device, &allocInfo, &bindlessSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bindless texture descriptor set!");
+    }
+    bindlessCapacity = capacity;
+}
+
+bool MyDescriptorManager::isBindless() const
+{
+    return bindlessSet != VK_NULL_HANDLE;
+}
+
+uint32_t MyDescriptorManager::getBindlessUsed() const
+{
+    return bindlessNext - static_cast<uint32_t>(freeBindlessSlots.size());
+}
+
+uint32_t MyDescriptorManager::getBindlessCapacity() const
+{
+    return bindlessCapacity;
+}
+
 std::vector<VkDescriptorSetLayout> MyDescriptorManager::getDescriptorSetLayout() const
 {
     return {globalDescriptorSetLayout, textureDescriptorSetLayout};
@@ -5,10 +5,17 @@
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <utility>
 
 class MyTexture;
 class MyDevice;
 
+// where a texture sits: its own set at index 0, or a slot of the bindless table
+struct TextureBinding
+{
+    VkDescriptorSet descriptor = VK_NULL_HANDLE;
+    uint32_t index = 0;
+};
 
 class MyDescriptorManager
 {
@@ -18,14 +25,35 @@ public:
 
     void createDescriptorSets(uint32_t numFrameBuffers,
         std::vector<std::shared_ptr<MyTexture>>& textures);
+    // textures get theirs later through createTextureDescriptorSet
+    void createGlobalDescriptorSets(uint32_t numFrameBuffers);
     void updateGlobalDescriptorSets(size_t i,
             VkDescriptorBufferInfo& bufferInfo);
     void updateTextureDescriptorSets(
         std::vector<std::shared_ptr<MyTexture>>& textures);
+    // allocate and write the set of a texture created after createDescriptorSets
+    void createTextureDescriptorSet(MyTexture& texture);
+    // a texture binding not tied to any texture yet, it must not be in use
+    // by a pending frame when it is written
+    TextureBinding allocateTextureBinding();
+    // a bindless slot is reused and a set of its own freed once no frame
+    // in flight can sample it anymore. Main thread
+    void freeTextureBinding(TextureBinding binding);
+    // main thread, once per frame before recording it
+    void update();
+    void writeTextureBinding(TextureBinding binding, const MyTexture& texture);
     void createGlobalDescriptorSetLayout(
             std::vector<VkDescriptorSetLayoutBinding> bindings);
     void createTextureDescriptorSetLayout(
             std::vector<VkDescriptorSetLayoutBinding> bindings);
+    // instead of createTextureDescriptorSetLayout: one update after bind set
+    // with a partially bound array of capacity samplers at binding 0, every
+    // texture takes a slot of it. Needs device.supportsBindlessTextures()
+    void createBindlessTextureTable(uint32_t capacity);
+    bool isBindless() const;
+    // slots taken, freed ones waiting for reuse included, and slots in the table
+    uint32_t getBindlessUsed() const;
+    uint32_t getBindlessCapacity() const;
 
     std::vector<VkDescriptorSetLayout> getDescriptorSetLayout() const;
     std::vector<VkDescriptorSet> getGlobalDescriptorSets(size_t i) const;
@@ -39,6 +67,16 @@ public:
 private:
     VkDescriptorSetLayout globalDescriptorSetLayout;
     VkDescriptorSetLayout textureDescriptorSetLayout;
+    VkDescriptorPool bindlessPool = VK_NULL_HANDLE;
+    VkDescriptorSet bindlessSet = VK_NULL_HANDLE;
+    uint32_t bindlessCapacity = 0;
+    uint32_t bindlessNext = 0; // slots from here on were never handed out
+    std::vector<uint32_t> freeBindlessSlots;
+    // slot and the frame it may be handed out again from
+    std::vector<std::pair<uint32_t, uint64_t>> retiredBindlessSlots;
+    // texture set and the frame it may be freed from
+    std::vector<std::pair<VkDescriptorSet, uint64_t>> retiredTextureSets;
+    uint64_t frame = 0;
 
     MyDevice& device;
 
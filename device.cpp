@@ -1,6 +1,8 @@
 #include "device.hpp"
 #include "utils.hpp"
 #include "window.hpp"
+#include "upload_scheduler.hpp"
+#include "sampler_cache.hpp"
 
 //libs
 #include <vulkan/vulkan.h>
@@ -12,6 +14,7 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <algorithm>
 
 //cstd
 #include <cstring>
@@ -28,12 +31,19 @@ MyDevice::MyDevice(MyWindow& window)
     : window(window)
 {
     setupDevice();
+    memoryAllocator = std::make_unique<MyMemoryAllocator>(*this);
     createCommandPool();
-    createTransferCommandPool();
+    commandContexts = std::make_unique<MyCommandContextPool>(*this);
+    uploadScheduler = std::make_unique<MyUploadScheduler>(*this);
+    samplerCache = std::make_unique<MySamplerCache>(*this);
 }
 
 MyDevice::~MyDevice()
 { 
+    uploadScheduler.reset();
+    samplerCache.reset();
+    commandContexts.reset();
+    memoryAllocator.reset();
     vkDestroyDescriptorPool(device, descriptorPool, nullptr);
     for (auto& [key, pool] : poolMap) {
         vkDestroyCommandPool(device, pool, nullptr);
@@ -73,6 +83,7 @@ void MyDevice::pickPhysicalDevice()
 
     if (candidates.rbegin()->first > 0) {
         physicalDevice = candidates.rbegin()->second;
+        capabilities = queryDeviceCapabilities(physicalDevice, findQueueFamilies(physicalDevice));
     }
     else {
         throw std::runtime_error("failed to find a suitable GPU!");
@@ -84,7 +95,7 @@ void MyDevice::pickPhysicalDevice()
  */
 void MyDevice::createLogicalDevice() 
 {
-    QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+    const QueueFamilyIndices& indices = capabilities.queueFamilies;
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {
         indices.graphicsFamily.value(),
@@ -102,20 +113,43 @@ void MyDevice::createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    const VkPhysicalDeviceFeatures& supportedFeatures = capabilities.features;
+
     VkPhysicalDeviceFeatures deviceFeatures{}; // we'll get back to it
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // BC textures are used where available, uncompressed ones otherwise
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    bindlessTextures = queryBindlessSupport();
+    if (bindlessTextures) {
+        vulkan12Features.descriptorIndexing = VK_TRUE;
+        vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    }
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = bindlessTextures ? &vulkan12Features : nullptr;
     createInfo.queueCreateInfoCount =
         static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
+    std::vector<const char*> extensions = deviceExtensions;
+    // queried with vkGetPhysicalDeviceMemoryProperties2, core in 1.1
+    memoryBudget = capabilities.hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+        && instanceApiVersion >= VK_API_VERSION_1_1
+        && capabilities.properties.apiVersion >= VK_API_VERSION_1_1;
+    if (memoryBudget)
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
     createInfo.enabledExtensionCount =
-        static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     //ignored by recent vulkan version, here for backwards compatibility
     if (enableValidationLayers) {
@@ -217,13 +251,61 @@ QueueFamilyIndices MyDevice::findQueueFamilies(VkPhysicalDevice device) const
     return indices;
 }
 
-VkSampleCountFlagBits MyDevice::getMaxUsableSampleCount() const
+bool MyDevice::queryBindlessSupport()
+{
+    if (capabilities.properties.apiVersion < VK_API_VERSION_1_2
+            || instanceApiVersion < VK_API_VERSION_1_2)
+        return false;
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &vulkan12Features;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    if (!vulkan12Features.descriptorIndexing
+            || !vulkan12Features.runtimeDescriptorArray
+            || !vulkan12Features.descriptorBindingPartiallyBound
+            || !vulkan12Features.descriptorBindingSampledImageUpdateAfterBind
+            || !vulkan12Features.shaderSampledImageArrayNonUniformIndexing)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+    vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &vulkan12Properties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+    maxBindlessTextures = std::min({
+            vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+            vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers,
+            vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers});
+    return maxBindlessTextures > 0;
+}
+
+bool MyDevice::supportsBindlessTextures() const
+{
+    return bindlessTextures;
+}
+
+uint32_t MyDevice::getMaxBindlessTextures() const
 {
-    VkPhysicalDeviceProperties physicalDeviceProperties;
-    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    return maxBindlessTextures;
+}
+
+bool MyDevice::supportsMemoryBudget() const
+{
+    return memoryBudget;
+}
 
-    VkSampleCountFlags counts = physicalDeviceProperties.limits.framebufferNoAttachmentsSampleCounts
-        & physicalDeviceProperties.limits.framebufferDepthSampleCounts;
+VkSampleCountFlagBits MyDevice::getMaxUsableSampleCount() const
+{
+    const VkPhysicalDeviceLimits& limits = capabilities.properties.limits;
+    VkSampleCountFlags counts = limits.framebufferNoAttachmentsSampleCounts
+        & limits.framebufferDepthSampleCounts;
     if (counts & VK_SAMPLE_COUNT_64_BIT) return VK_SAMPLE_COUNT_64_BIT;
     if (counts & VK_SAMPLE_COUNT_32_BIT) return VK_SAMPLE_COUNT_32_BIT;
     if (counts & VK_SAMPLE_COUNT_16_BIT) return VK_SAMPLE_COUNT_16_BIT;
@@ -247,7 +329,10 @@ void MyDevice::createInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1,0,0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1,0,0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    // 1.2 for descriptor indexing where the loader has it, a 1.0 loader
+    // rejects anything above 1.0
+    instanceApiVersion = std::min<uint32_t>(proxyEnumerateInstanceVersion(), VK_API_VERSION_1_2);
+    appInfo.apiVersion = instanceApiVersion;
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -424,8 +509,7 @@ void MyDevice::createSurface()
 
 uint32_t MyDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
 {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    const VkPhysicalDeviceMemoryProperties& memProperties = capabilities.memory;
     for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
         if (typeFilter & (1 << i)
                 && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) 
@@ -440,18 +524,24 @@ void MyDevice::createBuffer(VkDeviceSize size,
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory) const
+        MemoryAllocation& bufferMemory,
+        MemoryCategory category,
+        VkSharingMode sharingMode) const
 {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
     bufferInfo.usage = usage;
 
-    QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
-    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    const QueueFamilyIndices& indices = capabilities.queueFamilies;
     uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.transferFamily.value()};
-    bufferInfo.queueFamilyIndexCount = 2;
-    bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+    // concurrent across a single family is exclusive
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (sharingMode == VK_SHARING_MODE_CONCURRENT && hasSeparateTransferFamily()) {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
 
 
     if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer)
@@ -463,39 +553,113 @@ void MyDevice::createBuffer(VkDeviceSize size,
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) 
-            != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to allocate vertex buffer memory!");
+    try {
+        bufferMemory = memoryAllocator->allocate(memRequirements, properties,
+                MemoryResource::Linear, category);
+    } catch (...) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        throw;
     }
 
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    vkBindBufferMemory(device, buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
-VkCommandBuffer MyDevice::beginSingleCommands(CommandPool poolEnum)
-{ 
-    VkCommandPool& pool = poolMap[poolEnum];
+void MyDevice::destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory) const
+{
+    vkDestroyBuffer(device, buffer, nullptr);
+    memoryAllocator->free(bufferMemory);
+}
 
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = pool;
-    allocInfo.commandBufferCount = 1;
+bool MyDevice::hasSeparateTransferFamily() const
+{
+    return capabilities.queueFamilies.transferFamily != capabilities.queueFamilies.graphicsFamily;
+}
 
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+void MyDevice::recordBufferOwnershipTransfer(VkCommandBuffer transferCommands,
+        VkCommandBuffer graphicsCommands,
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        VkDeviceSize size,
+        VkAccessFlags dstAccessMask,
+        VkPipelineStageFlags dstStageMask) const
+{
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccessMask;
+
+    if (hasSeparateTransferFamily()) {
+        barrier.srcQueueFamilyIndex = capabilities.queueFamilies.transferFamily.value();
+        barrier.dstQueueFamilyIndex = capabilities.queueFamilies.graphicsFamily.value();
+        // the release only makes the writes available, dst access is the acquire's
+        VkBufferMemoryBarrier release = barrier;
+        release.dstAccessMask = 0;
+        vkCmdPipelineBarrier(transferCommands,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                0, nullptr,
+                1, &release,
+                0, nullptr);
+        barrier.srcAccessMask = 0;
+    }
+    // waits at the transfer stage on the semaphore the transfer submission signals
+    vkCmdPipelineBarrier(graphicsCommands,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+}
 
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+void MyDevice::recordImageOwnershipTransfer(VkCommandBuffer transferCommands,
+        VkCommandBuffer graphicsCommands,
+        VkImage image,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout,
+        VkAccessFlags dstAccessMask,
+        VkPipelineStageFlags dstStageMask) const
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccessMask;
+
+    if (hasSeparateTransferFamily()) {
+        barrier.srcQueueFamilyIndex = capabilities.queueFamilies.transferFamily.value();
+        barrier.dstQueueFamilyIndex = capabilities.queueFamilies.graphicsFamily.value();
+        // both halves name the same layouts, the transition happens once
+        VkImageMemoryBarrier release = barrier;
+        release.dstAccessMask = 0;
+        vkCmdPipelineBarrier(transferCommands,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                0, nullptr,
+                0, nullptr,
+                1, &release);
+        barrier.srcAccessMask = 0;
+    }
+    vkCmdPipelineBarrier(graphicsCommands,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+}
 
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    return commandBuffer;
+VkCommandBuffer MyDevice::beginSingleCommands(CommandPool poolEnum)
+{ 
+    return commandContexts->begin(poolEnum);
 }
 
 VkResult MyDevice::queueSubmit(DeviceQueue queue,
@@ -505,47 +669,102 @@ VkResult MyDevice::queueSubmit(DeviceQueue queue,
 {
     VkQueue _queue = queueMap[queue];
 
+    std::lock_guard<std::mutex> lock(queueMutex);
     return vkQueueSubmit(_queue, submitCount, pSubmitInfo, fence);
 }
 
 VkResult MyDevice::present(const VkPresentInfoKHR* pPresentInfo)
 {
+    std::lock_guard<std::mutex> lock(queueMutex);
     return vkQueuePresentKHR(queueMap[DeviceQueue::Present], pPresentInfo);
 }
 
-void MyDevice::endSingleCommands(VkCommandBuffer commandBuffer, 
-        CommandPool poolEnum,
-        DeviceQueue queue)
+void MyDevice::endSingleCommands(VkCommandBuffer commandBuffer, DeviceQueue queue)
 {
-    VkQueue _queue = queueMap[queue];
-    VkCommandPool& pool = poolMap[poolEnum];
-
-    vkEndCommandBuffer(commandBuffer);
+    VkFence fence = commandContexts->end(commandBuffer);
 
+    // wait for this submission only, not for everything else on the queue
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
-    vkQueueSubmit(_queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(_queue);
-    vkFreeCommandBuffers(device, pool, 1, &commandBuffer);
+    if (queueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+        // never executed, buffer and fence can be reused right away
+        commandContexts->recycle(commandBuffer, fence);
+        throw std::runtime_error("failed to submit single commands!");
+    }
+    // the command buffer goes back to its pool with the fence
+    commandContexts->submitted(commandBuffer, fence);
+    vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+}
+
+MyUploadScheduler& MyDevice::getUploadScheduler()
+{
+    return *uploadScheduler;
+}
+
+MySamplerCache& MyDevice::getSamplerCache()
+{
+    return *samplerCache;
 }
 
+MyMemoryAllocator& MyDevice::getMemoryAllocator() const
+{
+    return *memoryAllocator;
+}
+
+const MyCommandContextPool& MyDevice::getCommandContextPool() const
+{
+    return *commandContexts;
+}
+
+const DeviceCapabilities& MyDevice::getCapabilities() const
+{
+    return capabilities;
+}
+
+const VkPhysicalDeviceProperties& MyDevice::getProperties() const
+{
+    return capabilities.properties;
+}
+
+const QueueFamilyIndices& MyDevice::getQueueFamilies() const
+{
+    return capabilities.queueFamilies;
+}
+
+void MyDevice::recycleSingleCommands(VkCommandBuffer commandBuffer)
+{
+    commandContexts->recycle(commandBuffer);
+}
+
+void MyDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
+        VkDeviceSize srcOffset, VkDeviceSize dstOffset)
+{
+    VkCommandBuffer transferCommands = beginSingleCommands(CommandPool::Transfer);
+    VkCommandBuffer graphicsCommands = beginSingleCommands(CommandPool::Command);
+    recordCopyBuffer(transferCommands, srcBuffer, dstBuffer, size, srcOffset, dstOffset);
+    recordBufferOwnershipTransfer(transferCommands, graphicsCommands, dstBuffer, dstOffset, size,
+            VK_ACCESS_MEMORY_READ_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    // the release has completed before the acquire is submitted
+    endSingleCommands(transferCommands, DeviceQueue::Transfer);
+    endSingleCommands(graphicsCommands, DeviceQueue::Graphics);
+}
 
-void MyDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+void MyDevice::recordCopyBuffer(VkCommandBuffer commandBuffer,
+        VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
+        VkDeviceSize srcOffset, VkDeviceSize dstOffset) const
 {
-    VkCommandBuffer commandBuffer = beginSingleCommands(CommandPool::Transfer);
     VkBufferCopy copyRegion;
-    copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = dstOffset;
     copyRegion.size = size;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-    endSingleCommands(commandBuffer, CommandPool::Transfer, DeviceQueue::Transfer);
 }
 
 void MyDevice::createCommandPool()
 {
-    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+    const QueueFamilyIndices& queueFamilyIndices = capabilities.queueFamilies;
 
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -560,39 +779,24 @@ void MyDevice::createCommandPool()
     }
 }
 
-void MyDevice::createTransferCommandPool()
-{
-    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
-
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = queueFamilyIndices.transferFamily.value();
-    poolInfo.flags = 0;
-
-    poolMap[CommandPool::Transfer] = VkCommandPool();
-    if (vkCreateCommandPool(device, &poolInfo, nullptr, &poolMap[CommandPool::Transfer])
-            != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to create tranfer command pool!");
-    }
-}
-
 VkImageView MyDevice::createImageView(
         VkImage image, 
         VkFormat format, 
         VkImageAspectFlags aspectFlags,
-        uint32_t mipLevels) const
+        uint32_t mipLevels,
+        uint32_t layerCount,
+        VkImageViewType viewType) const
 {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = viewType;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = layerCount;
 
     VkImageView imageView;
     if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
@@ -608,8 +812,7 @@ VkFormat MyDevice::findSupportedFormat(
         VkFormatFeatureFlags features) const
 {
     for (VkFormat format : candidates) {
-        VkFormatProperties props;
-        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+        VkFormatProperties props = capabilities.getFormatProperties(format);
 
         if (tiling == VK_IMAGE_TILING_LINEAR
                 && (props.linearTilingFeatures & features) == features)
@@ -641,7 +844,9 @@ void MyDevice::createImage(uint32_t width, uint32_t height,
         VkImageUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory & imageMemory) const
+        MemoryAllocation& imageMemory,
+        MemoryCategory category,
+        uint32_t arrayLayers) const
 {
 
     VkImageCreateInfo imageInfo{};
@@ -651,7 +856,7 @@ void MyDevice::createImage(uint32_t width, uint32_t height,
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = mipLevels;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = arrayLayers;
     imageInfo.format = format; 
     imageInfo.tiling = tiling; 
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -666,19 +871,24 @@ void MyDevice::createImage(uint32_t width, uint32_t height,
         
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device, image, &memRequirements);
-        
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, 
-            properties);
-            
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate image memory!");
+    try {
+        imageMemory = memoryAllocator->allocate(memRequirements, properties,
+                tiling == VK_IMAGE_TILING_LINEAR ? MemoryResource::Linear
+                                                 : MemoryResource::Optimal,
+                category);
+    } catch (...) {
+        vkDestroyImage(device, image, nullptr);
+        throw;
     }
 
-    vkBindImageMemory(device, image, imageMemory, 0);
+    vkBindImageMemory(device, image, imageMemory.memory, imageMemory.offset);
+}
+
+void MyDevice::destroyImage(VkImage image, MemoryAllocation& imageMemory) const
+{
+    vkDestroyImage(device, image, nullptr);
+    memoryAllocator->free(imageMemory);
 }
 
 static bool hasStencilComponent(VkFormat format)
@@ -693,8 +903,18 @@ void MyDevice::transitionImageLayout(VkImage image,
         VkImageLayout newLayout,
         uint32_t mipLevels)
 {
-    VkCommandBuffer commandBuffer = beginSingleCommands(CommandPool::Transfer);
+    VkCommandBuffer commandBuffer = beginSingleCommands(CommandPool::Command);
+    recordTransitionImageLayout(commandBuffer, image, format, oldLayout, newLayout, mipLevels);
+    endSingleCommands(commandBuffer, DeviceQueue::Graphics);
+}
 
+void MyDevice::recordTransitionImageLayout(VkCommandBuffer commandBuffer,
+        VkImage image, 
+        VkFormat format, 
+        VkImageLayout oldLayout, 
+        VkImageLayout newLayout,
+        uint32_t mipLevels) const
+{
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
@@ -719,49 +939,23 @@ void MyDevice::transitionImageLayout(VkImage image,
         barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     }
 
+    // transitions only, ownership moves with recordImageOwnershipTransfer
     VkPipelineStageFlags sourceStage;
     VkPipelineStageFlags destinationStage;
-    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
     if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED
             && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) 
     {
         barrier.srcAccessMask = 0;
         barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.srcQueueFamilyIndex = queueFamilyIndices.transferFamily.value();
-        barrier.dstQueueFamilyIndex = queueFamilyIndices.transferFamily.value();
 
         sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
         destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
     }
     else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
             && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-    {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.srcQueueFamilyIndex = queueFamilyIndices.transferFamily.value();
-        barrier.dstQueueFamilyIndex = queueFamilyIndices.transferFamily.value();
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-            && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-    {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.srcQueueFamilyIndex = queueFamilyIndices.transferFamily.value();
-        barrier.dstQueueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-            && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
     {
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        barrier.srcQueueFamilyIndex = queueFamilyIndices.transferFamily.value();
-        barrier.dstQueueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
 
         sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
         destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
@@ -772,8 +966,6 @@ void MyDevice::transitionImageLayout(VkImage image,
         barrier.srcAccessMask = 0;
         barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT 
             | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        barrier.srcQueueFamilyIndex = queueFamilyIndices.transferFamily.value();
-        barrier.dstQueueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
 
         sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
         destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
@@ -788,21 +980,32 @@ void MyDevice::transitionImageLayout(VkImage image,
             0, nullptr,
             0, nullptr,
             1, &barrier);
-
-    endSingleCommands(commandBuffer, CommandPool::Transfer, DeviceQueue::Transfer);
 }
 
 void MyDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
 {
-    VkCommandBuffer commandBuffer = beginSingleCommands(CommandPool::Transfer);
+    VkCommandBuffer transferCommands = beginSingleCommands(CommandPool::Transfer);
+    VkCommandBuffer graphicsCommands = beginSingleCommands(CommandPool::Command);
+    recordCopyBufferToImage(transferCommands, buffer, image, width, height);
+    recordImageOwnershipTransfer(transferCommands, graphicsCommands, image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT);
+    endSingleCommands(transferCommands, DeviceQueue::Transfer);
+    endSingleCommands(graphicsCommands, DeviceQueue::Graphics);
+}
 
+void MyDevice::recordCopyBufferToImage(VkCommandBuffer commandBuffer,
+        VkBuffer buffer, VkImage image, uint32_t width, uint32_t height,
+        VkDeviceSize bufferOffset, uint32_t mipLevel) const
+{
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = bufferOffset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.mipLevel = mipLevel;
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
 
@@ -817,8 +1020,6 @@ void MyDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             1, 
             &region);
-
-    endSingleCommands(commandBuffer, CommandPool::Transfer, DeviceQueue::Transfer);
 }
 
 void MyDevice::allocateCommandBuffers(std::vector<VkCommandBuffer>* commandBuffers)
@@ -847,6 +1048,8 @@ void MyDevice::createDescriptorPool(std::vector<VkDescriptorPoolSize>& poolSizes
 {
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    // texture sets are freed when their texture unloads
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
     poolInfo.maxSets = maxSets;
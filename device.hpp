@@ -1,14 +1,21 @@
 #pragma once
 
+#include "memory_allocator.hpp"
+#include "device_capabilities.hpp"
+#include "command_context_pool.hpp"
+
 //libs
 #include <vulkan/vulkan.h>
 
 //std
-#include <optional>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
 
 class MyWindow;
+class MyUploadScheduler;
+class MySamplerCache;
 
 struct SwapChainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities;
@@ -16,19 +23,6 @@ struct SwapChainSupportDetails {
     std::vector<VkPresentModeKHR> presentModes;
 };
 
-struct QueueFamilyIndices
-{
-    std::optional<uint32_t> graphicsFamily;
-    std::optional<uint32_t> presentFamily;
-    std::optional<uint32_t> transferFamily;
-
-    bool isComplete() const {
-        return graphicsFamily.has_value() &&
-            presentFamily.has_value() && 
-            transferFamily.has_value();
-    }
-};
-
 enum class DeviceQueue
 {
     Graphics,
@@ -36,12 +30,6 @@ enum class DeviceQueue
     Transfer
 };
 
-enum class CommandPool
-{
-    Command,
-    Transfer
-};
-
 class MyDevice 
 {
 public:
@@ -54,27 +42,68 @@ public:
     void setupDevice();
     VkSampleCountFlagBits getMaxUsableSampleCount() const;
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) const;
+    // queries the driver, the picked device's are in getQueueFamilies
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+    // the memory is sub-allocated, bind nothing else to bufferMemory.memory.
+    // Owned by one queue family at a time unless concurrent sharing between
+    // graphics and transfer is asked for, hand over ranges the transfer
+    // queue wrote with recordBufferOwnershipTransfer
     void createBuffer(VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory) const;
+            MemoryAllocation& bufferMemory,
+            MemoryCategory category,
+            VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE) const;
+    void destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory) const;
+    // hand a buffer range written on the transfer queue to the graphics queue,
+    // the release goes into transferCommands and the acquire into
+    // graphicsCommands, which must run after them. With one queue family for
+    // both only a barrier is recorded, into graphicsCommands
+    void recordBufferOwnershipTransfer(VkCommandBuffer transferCommands,
+            VkCommandBuffer graphicsCommands,
+            VkBuffer buffer,
+            VkDeviceSize offset,
+            VkDeviceSize size,
+            VkAccessFlags dstAccessMask,
+            VkPipelineStageFlags dstStageMask) const;
+    // as for buffers, for every level and layer of image, which ends up in newLayout
+    void recordImageOwnershipTransfer(VkCommandBuffer transferCommands,
+            VkCommandBuffer graphicsCommands,
+            VkImage image,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout,
+            VkAccessFlags dstAccessMask,
+            VkPipelineStageFlags dstStageMask) const;
+    // transfer and graphics queues are of different families
+    bool hasSeparateTransferFamily() const;
+    // blocking, on the transfer queue, then handed to the graphics queue
     void copyBuffer(VkBuffer srcBuffer, 
             VkBuffer dstBuffer, 
-            VkDeviceSize size);
+            VkDeviceSize size,
+            VkDeviceSize srcOffset = 0,
+            VkDeviceSize dstOffset = 0);
+    void recordCopyBuffer(VkCommandBuffer commandBuffer,
+            VkBuffer srcBuffer,
+            VkBuffer dstBuffer,
+            VkDeviceSize size,
+            VkDeviceSize srcOffset = 0,
+            VkDeviceSize dstOffset = 0) const;
     void createCommandPool();
-    void createTransferCommandPool();
+    // from the calling thread's pools, see MyCommandContextPool
     VkCommandBuffer beginSingleCommands(CommandPool poolEnum);
-    void endSingleCommands(VkCommandBuffer commandBuffer, 
-            CommandPool poolEnum,
-            DeviceQueue queue);
+    // blocking, on the thread that began commandBuffer
+    void endSingleCommands(VkCommandBuffer commandBuffer, DeviceQueue queue);
+    // for single commands submitted by the caller, once they have completed
+    void recycleSingleCommands(VkCommandBuffer commandBuffer);
     VkImageView createImageView(
         VkImage image, 
         VkFormat format, 
         VkImageAspectFlags aspectFlags,
-        uint32_t mipLevels) const;
+        uint32_t mipLevels,
+        uint32_t layerCount = 1,
+        VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D) const;
     VkFormat findDepthFormat() const;
     void createImage(uint32_t width, uint32_t height, 
         uint32_t mipLevels,
@@ -84,21 +113,58 @@ public:
         VkImageUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory & imageMemory) const;
+        MemoryAllocation& imageMemory,
+        MemoryCategory category,
+        uint32_t arrayLayers = 1) const;
+    void destroyImage(VkImage image, MemoryAllocation& imageMemory) const;
+    // blocking, on the graphics queue
     void transitionImageLayout(VkImage image, 
         VkFormat format, 
         VkImageLayout oldLayout, 
         VkImageLayout newLayout,
         uint32_t mipLevels);
+    void recordTransitionImageLayout(VkCommandBuffer commandBuffer,
+        VkImage image, 
+        VkFormat format, 
+        VkImageLayout oldLayout, 
+        VkImageLayout newLayout,
+        uint32_t mipLevels) const;
+    // blocking, image in transfer dst layout, which it keeps when it is
+    // handed to the graphics queue
     void copyBufferToImage(VkBuffer buffer, 
             VkImage image, 
             uint32_t width, uint32_t height);
+    void recordCopyBufferToImage(VkCommandBuffer commandBuffer,
+            VkBuffer buffer, 
+            VkImage image, 
+            uint32_t width, uint32_t height,
+            VkDeviceSize bufferOffset = 0,
+            uint32_t mipLevel = 0) const;
     VkResult queueSubmit(
             DeviceQueue queue,
             uint32_t submitCount,
             const VkSubmitInfo* pSubmits,
             VkFence fence);
     VkResult present(const VkPresentInfoKHR* pPresentInfo);
+    // shared staging ring and batched transfer submissions
+    MyUploadScheduler& getUploadScheduler();
+    // samplers shared between textures with the same state
+    MySamplerCache& getSamplerCache();
+    // behind createBuffer and createImage
+    MyMemoryAllocator& getMemoryAllocator() const;
+    // behind beginSingleCommands
+    const MyCommandContextPool& getCommandContextPool() const;
+    // queried once when the physical device is picked
+    const DeviceCapabilities& getCapabilities() const;
+    const VkPhysicalDeviceProperties& getProperties() const;
+    const QueueFamilyIndices& getQueueFamilies() const;
+    // Vulkan 1.2 descriptor indexing with update after bind and partially
+    // bound sampled image arrays, enabled when the device has it
+    bool supportsBindlessTextures() const;
+    // sampled images one update after bind set may hold
+    uint32_t getMaxBindlessTextures() const;
+    // VK_EXT_memory_budget, enabled when the device has it
+    bool supportsMemoryBudget() const;
     void allocateCommandBuffers(std::vector<VkCommandBuffer>* commandBuffers);
     void freeCommandBuffers(std::vector<VkCommandBuffer>* commandBuffers);
 
@@ -118,6 +184,7 @@ private:
     int rateDeviceSuitability(VkPhysicalDevice device) const;
     std::vector<const char*> getRequiredExtensions() const;
     void createSurface();
+    bool queryBindlessSupport();
     VkFormat findSupportedFormat(
         const std::vector<VkFormat>& candidates,
         VkImageTiling tiling,
@@ -128,6 +195,18 @@ private:
     VkDebugUtilsMessengerEXT debugMessenger;
     std::map<CommandPool, VkCommandPool> poolMap;
     std::map<DeviceQueue, VkQueue> queueMap;
+    // submissions from loader threads, present may share a queue with graphics
+    std::mutex queueMutex;
+    std::unique_ptr<MyUploadScheduler> uploadScheduler;
+    std::unique_ptr<MySamplerCache> samplerCache;
+    std::unique_ptr<MyMemoryAllocator> memoryAllocator;
+    std::unique_ptr<MyCommandContextPool> commandContexts;
+    DeviceCapabilities capabilities;
+    bool bindlessTextures = false;
+    uint32_t maxBindlessTextures = 0;
+    bool memoryBudget = false;
+    // what the instance was created for, at most 1.2
+    uint32_t instanceApiVersion = VK_API_VERSION_1_0;
 
 #ifdef NDEBUG
     const bool enableValidationLayers = false;
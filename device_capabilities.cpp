@@ -0,0 +1,132 @@
+#include "device_capabilities.hpp"
+
+//std
+#include <algorithm>
+#include <cstring>
+#include <ios>
+
+// VK_FORMAT_ASTC_12x12_SRGB_BLOCK is the last core format of Vulkan 1.0
+static const uint32_t CORE_FORMAT_COUNT = VK_FORMAT_ASTC_12x12_SRGB_BLOCK + 1;
+
+DeviceCapabilities queryDeviceCapabilities(VkPhysicalDevice physicalDevice,
+        const QueueFamilyIndices& queueFamilies)
+{
+    DeviceCapabilities capabilities;
+    vkGetPhysicalDeviceProperties(physicalDevice, &capabilities.properties);
+    vkGetPhysicalDeviceFeatures(physicalDevice, &capabilities.features);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &capabilities.memory);
+    capabilities.queueFamilies = queueFamilies;
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    capabilities.queueFamilyProperties.resize(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount,
+            capabilities.queueFamilyProperties.data());
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount,
+            extensions.data());
+    for (const auto& extension : extensions)
+        capabilities.extensions.push_back(extension.extensionName);
+    std::sort(capabilities.extensions.begin(), capabilities.extensions.end());
+
+    capabilities.formats.resize(CORE_FORMAT_COUNT);
+    for (uint32_t format = 0; format < CORE_FORMAT_COUNT; format++) {
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, static_cast<VkFormat>(format),
+                &capabilities.formats[format]);
+    }
+    return capabilities;
+}
+
+bool DeviceCapabilities::hasExtension(const char* name) const
+{
+    return std::binary_search(extensions.begin(), extensions.end(), std::string(name));
+}
+
+VkFormatProperties DeviceCapabilities::getFormatProperties(VkFormat format) const
+{
+    uint32_t index = static_cast<uint32_t>(format);
+    return index < formats.size() ? formats[index] : VkFormatProperties{};
+}
+
+static const char* deviceTypeName(VkPhysicalDeviceType type)
+{
+    switch (type) {
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   return "discrete";
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    return "virtual";
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:            return "cpu";
+        default:                                     return "other";
+    }
+}
+
+void DeviceCapabilities::write(std::ostream& out) const
+{
+    const VkPhysicalDeviceLimits& limits = properties.limits;
+    out << "device " << properties.deviceName << "\n"
+        << "type " << deviceTypeName(properties.deviceType) << "\n"
+        << "api " << VK_VERSION_MAJOR(properties.apiVersion) << "."
+        << VK_VERSION_MINOR(properties.apiVersion) << "."
+        << VK_VERSION_PATCH(properties.apiVersion) << "\n"
+        << std::hex
+        << "driver 0x" << properties.driverVersion << "\n"
+        << "vendor 0x" << properties.vendorID << "\n"
+        << "id 0x" << properties.deviceID << "\n"
+        << std::dec;
+
+    // the limits the engine reads
+    out << "limit maxImageDimension2D " << limits.maxImageDimension2D << "\n"
+        << "limit maxImageArrayLayers " << limits.maxImageArrayLayers << "\n"
+        << "limit maxMemoryAllocationCount " << limits.maxMemoryAllocationCount << "\n"
+        << "limit maxSamplerAllocationCount " << limits.maxSamplerAllocationCount << "\n"
+        << "limit bufferImageGranularity " << limits.bufferImageGranularity << "\n"
+        << "limit nonCoherentAtomSize " << limits.nonCoherentAtomSize << "\n"
+        << "limit optimalBufferCopyOffsetAlignment "
+        << limits.optimalBufferCopyOffsetAlignment << "\n"
+        << "limit minUniformBufferOffsetAlignment "
+        << limits.minUniformBufferOffsetAlignment << "\n"
+        << "limit maxSamplerAnisotropy " << limits.maxSamplerAnisotropy << "\n"
+        << "limit maxSamplerLodBias " << limits.maxSamplerLodBias << "\n"
+        << "limit framebufferColorSampleCounts 0x" << std::hex
+        << limits.framebufferColorSampleCounts << "\n"
+        << "limit framebufferDepthSampleCounts 0x" << limits.framebufferDepthSampleCounts
+        << std::dec << "\n"
+        << "limit timestampPeriod " << limits.timestampPeriod << "\n"
+        << "limit timestampComputeAndGraphics " << limits.timestampComputeAndGraphics << "\n";
+
+    out << "feature samplerAnisotropy " << features.samplerAnisotropy << "\n"
+        << "feature textureCompressionBC " << features.textureCompressionBC << "\n"
+        << "feature multiDrawIndirect " << features.multiDrawIndirect << "\n";
+
+    for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+        out << "heap " << i << " " << memory.memoryHeaps[i].size << " 0x" << std::hex
+            << memory.memoryHeaps[i].flags << std::dec << "\n";
+    }
+    for (uint32_t i = 0; i < memory.memoryTypeCount; i++) {
+        out << "memory_type " << i << " heap " << memory.memoryTypes[i].heapIndex << " 0x"
+            << std::hex << memory.memoryTypes[i].propertyFlags << std::dec << "\n";
+    }
+    for (size_t i = 0; i < queueFamilyProperties.size(); i++) {
+        const VkQueueFamilyProperties& family = queueFamilyProperties[i];
+        out << "queue_family " << i << " 0x" << std::hex << family.queueFlags << std::dec
+            << " count " << family.queueCount << " timestamp_bits "
+            << family.timestampValidBits << "\n";
+    }
+    out << "queue graphics " << queueFamilies.graphicsFamily.value_or(~0u) << "\n"
+        << "queue present " << queueFamilies.presentFamily.value_or(~0u) << "\n"
+        << "queue transfer " << queueFamilies.transferFamily.value_or(~0u) << "\n";
+
+    for (const auto& extension : extensions)
+        out << "extension " << extension << "\n";
+    for (size_t i = 0; i < formats.size(); i++) {
+        const VkFormatProperties& format = formats[i];
+        if (!format.linearTilingFeatures && !format.optimalTilingFeatures
+                && !format.bufferFeatures)
+            continue;
+        out << "format " << i << std::hex << " 0x" << format.linearTilingFeatures
+            << " 0x" << format.optimalTilingFeatures << " 0x" << format.bufferFeatures
+            << std::dec << "\n";
+    }
+}
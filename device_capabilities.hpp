@@ -0,0 +1,51 @@
+#pragma once
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <optional>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+struct QueueFamilyIndices
+{
+    std::optional<uint32_t> graphicsFamily;
+    std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> transferFamily;
+
+    bool isComplete() const {
+        return graphicsFamily.has_value() &&
+            presentFamily.has_value() && 
+            transferFamily.has_value();
+    }
+};
+
+/* * *
+ * What the physical device offers, queried once when it is picked and
+ * never changed after. Code that used to ask the driver per buffer or per
+ * texture reads from here instead: properties and limits, features, memory
+ * types, queue families, format features of every core format and the
+ * supported extensions.
+ */
+struct DeviceCapabilities
+{
+    VkPhysicalDeviceProperties properties{};
+    VkPhysicalDeviceFeatures features{};
+    VkPhysicalDeviceMemoryProperties memory{};
+    QueueFamilyIndices queueFamilies;
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties;
+    std::vector<std::string> extensions; // sorted
+    std::vector<VkFormatProperties> formats; // indexed by VkFormat
+
+    bool hasExtension(const char* name) const;
+    // no features for formats past the core ones
+    VkFormatProperties getFormatProperties(VkFormat format) const;
+    // text, one "key value..." line per entry, formats only if they have features
+    void write(std::ostream& out) const;
+};
+
+DeviceCapabilities queryDeviceCapabilities(VkPhysicalDevice physicalDevice,
+        const QueueFamilyIndices& queueFamilies);
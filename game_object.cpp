@@ -9,8 +9,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 MyGameObject MyGameObject::createGameObject(
-        std::shared_ptr<MyModel> model,
-        std::shared_ptr<MyTexture> texture)
+        MyAssetHandle<MyModel> model,
+        MyAssetHandle<MyTexture> texture)
 {
     static uint32_t currentId;
     return MyGameObject{currentId++, model, texture};
@@ -23,8 +23,8 @@ MyGameObject MyGameObject::createGameObject()
 }
 
 MyGameObject::MyGameObject(uint32_t id,
-        std::shared_ptr<MyModel> model,
-        std::shared_ptr<MyTexture> texture)
+        MyAssetHandle<MyModel> model,
+        MyAssetHandle<MyTexture> texture)
     : id(id),
       model(model),
       texture(texture)
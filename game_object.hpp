@@ -1,6 +1,7 @@
 #pragma once
 
 #include "transform_component.hpp"
+#include "asset_handle.hpp"
 
 #include <memory>
 
@@ -11,20 +12,22 @@ class MyGameObject
 {
 public:
     static MyGameObject createGameObject(
-            std::shared_ptr<MyModel> model,
-            std::shared_ptr<MyTexture> texture);
+            MyAssetHandle<MyModel> model,
+            MyAssetHandle<MyTexture> texture);
     static MyGameObject createGameObject();
 
     uint32_t getId() const;
 
-    std::shared_ptr<MyModel> model{};
-    std::shared_ptr<MyTexture> texture{};
+    MyAssetHandle<MyModel> model{};
+    MyAssetHandle<MyTexture> texture{};
+    // layer of texture to sample, set when packed into an array
+    uint32_t textureLayer = 0;
     MyTransformComponent transform{};
 
 private:
     MyGameObject(uint32_t id,
-            std::shared_ptr<MyModel> model,
-            std::shared_ptr<MyTexture> texture);
+            MyAssetHandle<MyModel> model,
+            MyAssetHandle<MyTexture> texture);
     MyGameObject(uint32_t id);
 
     uint32_t id;
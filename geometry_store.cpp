@@ -0,0 +1,144 @@
+#include "geometry_store.hpp"
+#include "device.hpp"
+#include "vertex.hpp"
+#include "upload_scheduler.hpp"
+#include "swapchain.hpp"
+
+//std
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+// a frame recorded in update n is done once update n + FRAME_DELAY starts
+static const uint64_t FRAME_DELAY = MySwapChain::MAX_FRAMES_IN_FLIGHT + 1;
+
+MyGeometryStore::MyGeometryStore(MyDevice& device,
+        uint32_t vertexCapacity,
+        uint32_t indexCapacity)
+    : device(device),
+      vertexRanges(vertexCapacity),
+      indexRanges(indexCapacity)
+{
+    device.createBuffer(
+            sizeof(Vertex) * static_cast<VkDeviceSize>(vertexCapacity),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            vertexBuffer,
+            vertexBufferMemory,
+            MemoryCategory::Geometry);
+    device.createBuffer(
+            sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCapacity),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            indexBuffer,
+            indexBufferMemory,
+            MemoryCategory::Geometry);
+}
+
+MyGeometryStore::~MyGeometryStore()
+{
+    device.destroyBuffer(vertexBuffer, vertexBufferMemory);
+    device.destroyBuffer(indexBuffer, indexBufferMemory);
+}
+
+GeometryAllocation MyGeometryStore::allocate(const Vertex* vertexData,
+        uint32_t vertexCount,
+        const uint32_t* indexData,
+        uint32_t indexCount)
+{
+    GeometryAllocation allocation = allocate(vertexCount, indexCount);
+
+    size_t vertexSize = sizeof(Vertex) * static_cast<size_t>(vertexCount);
+    MyUploadScheduler& uploads = device.getUploadScheduler();
+    StagingRange staging = uploads.stage(getUploadSize(allocation));
+    memcpy(staging.data, vertexData, vertexSize);
+    memcpy(static_cast<char*>(staging.data) + vertexSize, indexData,
+            sizeof(uint32_t) * static_cast<size_t>(indexCount));
+    recordUpload(uploads, allocation, staging.buffer, staging.offset);
+    uploads.wait(uploads.flush());
+
+    return allocation;
+}
+
+GeometryAllocation MyGeometryStore::allocate(uint32_t vertexCount, uint32_t indexCount)
+{
+    uint64_t vertexOffset = vertexRanges.allocate(vertexCount);
+    if (vertexOffset == MyRangeAllocator::INVALID_OFFSET)
+        throw std::runtime_error("failed to allocate vertex range in geometry store!");
+    uint64_t firstIndex = indexRanges.allocate(indexCount);
+    if (firstIndex == MyRangeAllocator::INVALID_OFFSET) {
+        vertexRanges.free(vertexOffset);
+        throw std::runtime_error("failed to allocate index range in geometry store!");
+    }
+
+    GeometryAllocation allocation;
+    allocation.vertexOffset = static_cast<uint32_t>(vertexOffset);
+    allocation.vertexCount = vertexCount;
+    allocation.firstIndex = static_cast<uint32_t>(firstIndex);
+    allocation.indexCount = indexCount;
+    return allocation;
+}
+
+VkDeviceSize MyGeometryStore::getUploadSize(const GeometryAllocation& allocation)
+{
+    return sizeof(Vertex) * static_cast<VkDeviceSize>(allocation.vertexCount)
+        + sizeof(uint32_t) * static_cast<VkDeviceSize>(allocation.indexCount);
+}
+
+void MyGeometryStore::recordUpload(MyUploadScheduler& uploads,
+        const GeometryAllocation& allocation,
+        VkBuffer stagingBuffer,
+        VkDeviceSize stagingOffset) const
+{
+    VkDeviceSize vertexSize = sizeof(Vertex) * static_cast<VkDeviceSize>(allocation.vertexCount);
+    VkDeviceSize indexSize = sizeof(uint32_t) * static_cast<VkDeviceSize>(allocation.indexCount);
+    VkDeviceSize vertexOffset = sizeof(Vertex) * static_cast<VkDeviceSize>(allocation.vertexOffset);
+    VkDeviceSize indexOffset = sizeof(uint32_t) * static_cast<VkDeviceSize>(allocation.firstIndex);
+    VkCommandBuffer transferCommands = uploads.getTransferCommands();
+    device.recordCopyBuffer(transferCommands, stagingBuffer, vertexBuffer, vertexSize,
+            stagingOffset, vertexOffset);
+    device.recordCopyBuffer(transferCommands, stagingBuffer, indexBuffer, indexSize,
+            stagingOffset + vertexSize, indexOffset);
+
+    // only the written ranges change owner, draws of other models keep going
+    VkCommandBuffer graphicsCommands = uploads.getGraphicsCommands();
+    device.recordBufferOwnershipTransfer(transferCommands, graphicsCommands,
+            vertexBuffer, vertexOffset, vertexSize,
+            VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    device.recordBufferOwnershipTransfer(transferCommands, graphicsCommands,
+            indexBuffer, indexOffset, indexSize,
+            VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+}
+
+void MyGeometryStore::free(const GeometryAllocation& allocation)
+{
+    retired.push_back({allocation, frame + FRAME_DELAY});
+}
+
+void MyGeometryStore::update()
+{
+    frame++;
+    auto reusable = std::partition(retired.begin(), retired.end(),
+            [this](const Retired& r) { return r.frame > frame; });
+    for (auto r = reusable; r != retired.end(); r++) {
+        vertexRanges.free(r->allocation.vertexOffset);
+        indexRanges.free(r->allocation.firstIndex);
+    }
+    retired.erase(reusable, retired.end());
+}
+
+void MyGeometryStore::bind(VkCommandBuffer commandBuffer) const
+{
+    VkBuffer vertexBuffers[] = {vertexBuffer};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+GeometryStoreStats MyGeometryStore::getStats() const
+{
+    GeometryStoreStats stats;
+    stats.vertices = vertexRanges.getStats();
+    stats.indices = indexRanges.getStats();
+    return stats;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "range_allocator.hpp"
+#include "memory_allocator.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <vector>
+#include <cstdint>
+
+struct Vertex;
+class MyDevice;
+class MyUploadScheduler;
+
+// where a model's data sits in the store, in vertices and indices
+struct GeometryAllocation
+{
+    uint32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+struct GeometryStoreStats
+{
+    RangeAllocatorStats vertices;
+    RangeAllocatorStats indices;
+};
+
+/* * *
+ * One device local vertex buffer and one index buffer shared by every
+ * model. Models get a vertex and an index range and draw with
+ * vertexOffset/firstIndex, so the buffers are bound once per frame.
+ * Capacities are fixed at creation, an allocation that does not fit
+ * throws.
+ */
+class MyGeometryStore
+{
+public:
+    MyGeometryStore(MyDevice& device,
+            uint32_t vertexCapacity = 1u << 20,
+            uint32_t indexCapacity = 1u << 22);
+    ~MyGeometryStore();
+
+    MyGeometryStore(const MyGeometryStore& other) = delete;
+    MyGeometryStore& operator=(const MyGeometryStore& other) = delete;
+
+    // reserve ranges and upload the data into them, blocks until the copy is done
+    GeometryAllocation allocate(const Vertex* vertexData,
+            uint32_t vertexCount,
+            const uint32_t* indexData,
+            uint32_t indexCount);
+    // only reserve the ranges, fill them with recordUpload
+    GeometryAllocation allocate(uint32_t vertexCount, uint32_t indexCount);
+    // the ranges are reused once no frame in flight can draw from them
+    // anymore, see update
+    void free(const GeometryAllocation& allocation);
+    // main thread, once per frame before recording it
+    void update();
+
+    // staging holds the vertices at stagingOffset followed by the indices
+    static VkDeviceSize getUploadSize(const GeometryAllocation& allocation);
+    // copies on the transfer queue, the ranges are handed to the graphics queue
+    void recordUpload(MyUploadScheduler& uploads,
+            const GeometryAllocation& allocation,
+            VkBuffer stagingBuffer,
+            VkDeviceSize stagingOffset) const;
+
+    void bind(VkCommandBuffer commandBuffer) const;
+
+    GeometryStoreStats getStats() const;
+
+private:
+    struct Retired
+    {
+        GeometryAllocation allocation;
+        uint64_t frame = 0; // freed from this frame on
+    };
+
+    MyDevice& device;
+    MyRangeAllocator vertexRanges;
+    MyRangeAllocator indexRanges;
+    VkBuffer vertexBuffer;
+    VkBuffer indexBuffer;
+    MemoryAllocation vertexBufferMemory;
+    MemoryAllocation indexBufferMemory;
+    std::vector<Retired> retired;
+    uint64_t frame = 0;
+};
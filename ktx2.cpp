@@ -0,0 +1,116 @@
+#include "ktx2.hpp"
+#include "asset_archive.hpp"
+
+//std
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+uint32_t getBlockSize(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return 8;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+bool isSupportedKtx2Format(VkFormat format)
+{
+    return getBlockSize(format) != 0
+        || format == VK_FORMAT_R8G8B8A8_UNORM
+        || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+    uint32_t blockSize = getBlockSize(format);
+    if (blockSize == 0)
+        return static_cast<VkDeviceSize>(width) * height * 4;
+    return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+TextureImage loadKtx2(const char* path, uint32_t baseLevel)
+{
+    MyAssetFile file(path);
+    const char* data = file.data();
+
+    Ktx2Header header;
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("failed to read ktx2 header!");
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        throw std::runtime_error("file is not a ktx2 texture!");
+    }
+
+    VkFormat format = static_cast<VkFormat>(header.vkFormat);
+    if (!isSupportedKtx2Format(format)
+            || header.supercompressionScheme != 0
+            || header.pixelDepth > 1
+            || header.layerCount > 1
+            || header.faceCount != 1
+            || header.pixelWidth == 0
+            || header.pixelHeight == 0
+            || header.levelCount == 0)
+    {
+        throw std::runtime_error("unsupported ktx2 texture, expected 2D BC1/BC3/BC5/BC7 or RGBA8 with mips!");
+    }
+
+    if (baseLevel >= header.levelCount) {
+        throw std::runtime_error("ktx2 base level out of range!");
+    }
+
+    size_t indexSize = sizeof(Ktx2LevelIndex) * header.levelCount;
+    if (file.size() < sizeof(header) + indexSize) {
+        throw std::runtime_error("failed to read ktx2 level index!");
+    }
+
+    TextureImage image;
+    image.width = header.pixelWidth;
+    image.height = header.pixelHeight;
+    image.format = format;
+    image.levels.resize(header.levelCount);
+
+    // levels are stored smallest first, we keep level 0 first with offsets
+    // aligned for vkCmdCopyBufferToImage
+    VkDeviceSize alignment = std::max<VkDeviceSize>(getBlockSize(format), 4);
+    VkDeviceSize total = 0;
+    std::vector<Ktx2LevelIndex> index(header.levelCount);
+    memcpy(index.data(), data + sizeof(header), indexSize);
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        TextureLevel& level = image.levels[i];
+        level.width = std::max(header.pixelWidth >> i, 1u);
+        level.height = std::max(header.pixelHeight >> i, 1u);
+        level.size = getLevelSize(format, level.width, level.height);
+        if (index[i].byteLength != level.size
+                || index[i].byteOffset > file.size()
+                || index[i].byteLength > file.size() - index[i].byteOffset)
+        {
+            throw std::runtime_error("ktx2 level out of range!");
+        }
+        if (i < baseLevel)
+            continue;
+        total = (total + alignment - 1) / alignment * alignment;
+        level.offset = total;
+        total += level.size;
+    }
+
+    image.pixels.resize(static_cast<size_t>(total));
+    for (uint32_t i = baseLevel; i < header.levelCount; i++) {
+        memcpy(image.pixels.data() + image.levels[i].offset,
+                data + index[i].byteOffset,
+                static_cast<size_t>(image.levels[i].size));
+    }
+    return image;
+}
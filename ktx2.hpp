@@ -0,0 +1,56 @@
+#pragma once
+
+#include "texture.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <cstdint>
+
+static const uint8_t KTX2_IDENTIFIER[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+struct Ktx2Header
+{
+    uint8_t  identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+// follows the header, one per level with level 0 first
+struct Ktx2LevelIndex
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+// bytes per 4x4 block of the BC formats, 0 for anything else
+uint32_t getBlockSize(VkFormat format);
+// RGBA8 and BC1/BC3/BC5/BC7 are the formats we read and write
+bool isSupportedKtx2Format(VkFormat format);
+// bytes of one level, whole blocks for block compressed formats
+VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+/* * *
+ * Reads a 2D KTX2 file without supercompression into image, with every
+ * level it stores. Throws on anything else. From a baseLevel on only those
+ * levels are read, the ones above keep their size but have no pixels and
+ * baseLevel starts at offset 0.
+ */
+TextureImage loadKtx2(const char* path, uint32_t baseLevel = 0);
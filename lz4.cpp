@@ -0,0 +1,150 @@
+#include "lz4.hpp"
+
+//std
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+static const size_t MIN_MATCH = 4;
+// the last match starts at least 12 bytes and ends at least 5 bytes before the end
+static const size_t MATCH_START_LIMIT = 12;
+static const size_t LAST_LITERALS = 5;
+static const size_t MAX_OFFSET = 65535;
+static const uint32_t HASH_BITS = 16;
+
+static uint32_t read32(const char* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hash32(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// lengths of 15 and more continue in bytes of 255 and a remainder
+static void writeLength(std::vector<char>& out, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        out.push_back(static_cast<char>(255));
+    out.push_back(static_cast<char>(length));
+}
+
+static void writeSequence(std::vector<char>& out,
+        const char* literals, size_t literalLength,
+        size_t offset, size_t matchLength)
+{
+    size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4)
+            | std::min<size_t>(matchCode, 15));
+    out.push_back(static_cast<char>(token));
+    if (literalLength >= 15)
+        writeLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+    // the last sequence is literals only
+    if (matchLength == 0)
+        return;
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15)
+        writeLength(out, matchCode - 15);
+}
+
+std::vector<char> lz4Compress(const char* source, size_t size)
+{
+    std::vector<char> out;
+    out.reserve(size + size / 255 + 16);
+
+    size_t anchor = 0;
+    if (size > MATCH_START_LIMIT) {
+        // positions + 1, 0 is empty
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+        size_t matchEnd = size - LAST_LITERALS;
+        size_t position = 0;
+        while (position + MATCH_START_LIMIT <= size) {
+            uint32_t sequence = read32(source + position);
+            uint32_t& slot = table[hash32(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(position + 1);
+            if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET
+                    || read32(source + candidate - 1) != sequence)
+            {
+                position++;
+                continue;
+            }
+            candidate--;
+
+            size_t length = MIN_MATCH;
+            while (position + length < matchEnd && source[candidate + length] == source[position + length])
+                length++;
+            writeSequence(out, source + anchor, position - anchor, position - candidate, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    writeSequence(out, source + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+static size_t readLength(const uint8_t*& in, const uint8_t* end)
+{
+    size_t length = 0;
+    uint8_t byte;
+    do {
+        if (in == end) {
+            throw std::runtime_error("failed to decompress lz4 block, truncated length!");
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+void lz4Decompress(const char* source, size_t sourceSize, char* destination, size_t size)
+{
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(source);
+    const uint8_t* inEnd = in + sourceSize;
+    size_t written = 0;
+    while (true) {
+        if (in == inEnd) {
+            throw std::runtime_error("failed to decompress lz4 block, truncated sequence!");
+        }
+        uint8_t token = *in++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15)
+            literalLength += readLength(in, inEnd);
+        if (literalLength > static_cast<size_t>(inEnd - in) || literalLength > size - written) {
+            throw std::runtime_error("failed to decompress lz4 block, literals out of bounds!");
+        }
+        memcpy(destination + written, in, literalLength);
+        in += literalLength;
+        written += literalLength;
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2) {
+            throw std::runtime_error("failed to decompress lz4 block, truncated offset!");
+        }
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15)
+            matchLength += readLength(in, inEnd);
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > written || matchLength > size - written) {
+            throw std::runtime_error("failed to decompress lz4 block, match out of bounds!");
+        }
+        // matches may overlap what they write, copy bytewise
+        const char* match = destination + written - offset;
+        for (size_t i = 0; i < matchLength; i++)
+            destination[written + i] = match[i];
+        written += matchLength;
+    }
+    if (written != size) {
+        throw std::runtime_error("failed to decompress lz4 block, wrong size!");
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+//std
+#include <vector>
+#include <cstddef>
+
+/* * *
+ * LZ4 block format, without the frame around it. Compatible with the
+ * reference lz4 block functions, a single greedy pass with a 64K entry
+ * hash table, aimed at fast decompression of assets rather than ratio.
+ */
+
+// compressed block of size bytes at source
+std::vector<char> lz4Compress(const char* source, size_t size);
+// decompress a block into exactly size bytes at destination, throws if the
+// block is malformed or does not decompress to size
+void lz4Decompress(const char* source, size_t sourceSize, char* destination, size_t size);
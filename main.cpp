@@ -8,6 +8,18 @@
 #include "camera.hpp"
 #include "descriptor_manager.hpp"
 #include "movement_system.hpp"
+#include "geometry_store.hpp"
+#include "asset_loader.hpp"
+#include "upload_scheduler.hpp"
+#include "texture_streamer.hpp"
+#include "sampler_cache.hpp"
+#include "texture_packer.hpp"
+#include "mapped_file.hpp"
+#include "asset_archive.hpp"
+#include "asset_manifest.hpp"
+#include "memory_budget_log.hpp"
+#include "obj_loader.hpp"
+#include "vertex.hpp"
 
 //libs
 #include <vulkan/vulkan_core.h>
@@ -24,10 +36,40 @@
 #include <array>
 #include <chrono>
 #include <memory>
+#include <string>
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
 
 //cstd - why is memcpy in cstring
 #include <cstring> 
 
+// texture descriptor sets the pool has room for, placeholders included
+static const uint32_t MAX_TEXTURES = 256;
+// slots of the bindless texture table, if the device supports it
+static const uint32_t MAX_BINDLESS_TEXTURES = 4096;
+// written by make archive
+static const char* ASSET_ARCHIVE = "build/assets.pak";
+static const char* COOKED_MANIFEST = "build/cooked/manifest.txt";
+// parsed by --obj-bench, --dedup-bench and --model-bench unless a file is given
+static const char* BENCHMARK_MODEL = "models/companion_cube.obj";
+// cycled through by --texture-bench
+static const std::vector<std::string> BENCHMARK_TEXTURES = {
+    "textures/companion_cube.png",
+    "textures/companion_cube_blue.png"
+};
+// device memory streamed textures may keep resident
+static const VkDeviceSize TEXTURE_BUDGET = 256 * 1024 * 1024;
+// memory by category and heap, a row per interval while running
+static const char* MEMORY_LOG = "build/memory.csv";
+static const float MEMORY_LOG_INTERVAL = 1.f;
+// the capability snapshot, for startup diagnostics without a driver query
+static const char* DEVICE_CAPABILITIES = "build/device.txt";
+
 struct UniformBufferObject {
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
@@ -43,40 +85,403 @@ public:
     }
 
     void run() {
-        createGameObjects();
         initVulkan();
+        createGameObjects();
         mainLoop();
+        printGeometryStats();
+        printMemoryStats();
+        printUploadStats();
+        printCommandStats();
+        printAssetStats();
+        printStreamingStats();
+        printSamplerStats();
+        printPackerStats();
+        printFileStats();
+    }
+
+    // loads textureCount textures one by one, then as one batch, and prints both times
+    void benchmarkTextures(size_t textureCount)
+    {
+        initVulkan();
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < textureCount; i++)
+            paths.push_back(BENCHMARK_TEXTURES[i % BENCHMARK_TEXTURES.size()]);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::shared_ptr<MyTexture>> serial;
+        for (const auto& path : paths)
+            serial.push_back(std::make_shared<MyTexture>(device, path.c_str()));
+        auto serialEnd = std::chrono::high_resolution_clock::now();
+        serial.clear();
+
+        auto batchStart = std::chrono::high_resolution_clock::now();
+        auto batch = MyTexture::createBatch(device, paths);
+        auto batchEnd = std::chrono::high_resolution_clock::now();
+
+        float serialTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                serialEnd - start).count();
+        float batchTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                batchEnd - batchStart).count();
+        std::cout << textureCount << " textures: serial " << serialTime << " ms, batch "
+            << batchTime << " ms on " << std::thread::hardware_concurrency()
+            << " threads, " << serialTime / std::max(batchTime, 0.001f) << "x\n";
+        printUploadStats();
+    }
+
+    // creates and destroys bufferCount small buffers, and times the driver
+    // queries every creation made before the capability snapshot. The old
+    // path is not run any more, its time is the sum of the two measurements
+    void benchmarkBuffers(size_t bufferCount)
+    {
+        // kept so the queries are not dropped as unused
+        size_t completeQueries = 0;
+        auto queryStart = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < bufferCount; i++) {
+            QueueFamilyIndices indices = device.findQueueFamilies(device.physicalDevice);
+            VkPhysicalDeviceMemoryProperties memProperties;
+            vkGetPhysicalDeviceMemoryProperties(device.physicalDevice, &memProperties);
+            if (indices.isComplete() && memProperties.memoryTypeCount > 0)
+                completeQueries++;
+        }
+        auto queryEnd = std::chrono::high_resolution_clock::now();
+
+        std::vector<VkBuffer> buffers(bufferCount);
+        std::vector<MemoryAllocation> memory(bufferCount);
+        auto createStart = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < bufferCount; i++) {
+            device.createBuffer(256,
+                    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    buffers[i],
+                    memory[i],
+                    MemoryCategory::Uniforms);
+        }
+        auto createEnd = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < bufferCount; i++)
+            device.destroyBuffer(buffers[i], memory[i]);
+
+        float queryTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                queryEnd - queryStart).count();
+        float createTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                createEnd - createStart).count();
+        std::cout << bufferCount << " buffers: " << createTime << " ms with the snapshot (measured), "
+            << createTime + queryTime << " ms with the per buffer queries (derived, creation plus "
+            << queryTime << " ms for " << completeQueries << " separately timed queries)\n";
+        printMemoryStats();
+    }
+
+    // parses modelPath with tinyobjloader and with loadObjParallel on 1, 2,
+    // 4... up to all hardware threads, and prints the throughput of each and
+    // how many corners of the triangles differ from tinyobjloader's
+    void benchmarkObj(const char* modelPath)
+    {
+        double megabytes = MyAssetFile::getSize(modelPath) / (1024.0 * 1024.0);
+        auto serialStart = std::chrono::high_resolution_clock::now();
+        MyModel serial;
+        serial.loadObjSerial(modelPath);
+        float serialTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                std::chrono::high_resolution_clock::now() - serialStart).count();
+        std::cout << modelPath << ": " << megabytes << " MiB, tinyobjloader " << serialTime
+            << " ms (" << megabytes / (serialTime / 1000.0) << " MiB/s)\n";
+
+        unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            ObjLoadStats stats;
+            loadObjParallel(modelPath, vertices, indices, threads, &stats);
+            float time = stats.parseTime + stats.mergeTime;
+
+            size_t differing = 0;
+            if (indices.size() != serial.getIndexCount()) {
+                differing = indices.size();
+            }
+            else {
+                for (size_t i = 0; i < indices.size(); i++) {
+                    if (!(vertices[indices[i]] == serial.getVertexData()[serial.getIndexData()[i]]))
+                        differing++;
+                }
+            }
+            std::cout << "  " << stats.threads << " threads: parse " << stats.parseTime
+                << " ms, merge " << stats.mergeTime << " ms ("
+                << megabytes / (time / 1000.0) << " MiB/s, "
+                << serialTime / std::max(time, 0.001f) << "x), "
+                << vertices.size() << " vertices, " << differing << " of "
+                << indices.size() << " corners differ\n";
+            if (threads == maxThreads)
+                break;
+        }
+    }
+
+    // times the obj parse, the whole cold build and its steps and, after
+    // writing the mesh cache beside the source, the warm load of that cache
+    void benchmarkModel(const char* modelPath)
+    {
+        auto parseStart = std::chrono::high_resolution_clock::now();
+        MyModel parsed;
+        parsed.loadModel(modelPath);
+        auto coldStart = std::chrono::high_resolution_clock::now();
+        MyModel cold;
+        cold.build(modelPath);
+        if (!cold.writeCachedModel(modelPath)) {
+            throw std::runtime_error("failed to write the mesh cache!");
+        }
+        auto warmStart = std::chrono::high_resolution_clock::now();
+        MyModel warm;
+        if (!warm.loadCachedModel(modelPath)) {
+            throw std::runtime_error("failed to load the mesh cache just written!");
+        }
+        auto warmEnd = std::chrono::high_resolution_clock::now();
+
+        float parseTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                coldStart - parseStart).count();
+        float coldTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                warmStart - coldStart).count();
+        float warmTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                warmEnd - warmStart).count();
+        std::cout << modelPath << ": obj parse " << parseTime << " ms, cold build and cache write "
+            << coldTime << " ms, warm cache load " << warmTime << " ms ("
+            << coldTime / std::max(warmTime, 0.001f) << "x)\n";
+
+        const ModelLoadStats& stats = cold.getLoadStats();
+        std::cout << "  " << stats.vertices << " vertices, parse ";
+        if (stats.parallelParse.threads > 0) {
+            std::cout << stats.parallelParse.parseTime + stats.parallelParse.mergeTime << " ms on "
+                << stats.parallelParse.threads << " threads";
+        }
+        else {
+            std::cout << stats.serialParseTime << " ms (dedup " << stats.dedupTime << " ms)";
+        }
+        std::cout << ", optimize " << stats.optimizeTime << " ms (ACMR " << stats.acmrBefore
+            << " -> " << stats.acmrAfter << "), lods " << stats.simplifyTime << " ms (";
+        for (uint32_t i = 0; i < cold.getLodCount(); i++)
+            std::cout << (i > 0 ? " " : "") << cold.getLodTriangleCount(i);
+        std::cout << " triangles), meshlets " << stats.meshletTime << " ms ("
+            << cold.getMeshlets().size() << ")\n";
+    }
+
+    // deduplicates the vertex stream of modelPath, one vertex per index,
+    // with the std::unordered_map the loader used before and with
+    // MyVertexDedupTable, best of runs each
+    void benchmarkDedup(const char* modelPath, int runs = 5)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        loadObjParallel(modelPath, vertices, indices);
+        std::vector<Vertex> stream;
+        stream.reserve(indices.size());
+        for (uint32_t index : indices)
+            stream.push_back(vertices[index]);
+
+        float mapTime = std::numeric_limits<float>::max();
+        float tableTime = std::numeric_limits<float>::max();
+        size_t mapUnique = 0;
+        size_t tableUnique = 0;
+        for (int run = 0; run < runs; run++) {
+            auto mapStart = std::chrono::high_resolution_clock::now();
+            std::unordered_map<Vertex, uint32_t> uniqueVertices;
+            std::vector<Vertex> mapVertices;
+            std::vector<uint32_t> mapIndices;
+            mapIndices.reserve(stream.size());
+            for (const Vertex& vertex : stream) {
+                if (uniqueVertices.count(vertex) == 0) {
+                    uniqueVertices[vertex] = static_cast<uint32_t>(mapVertices.size());
+                    mapVertices.push_back(vertex);
+                }
+                mapIndices.push_back(uniqueVertices[vertex]);
+            }
+            auto mapEnd = std::chrono::high_resolution_clock::now();
+
+            MyVertexDedupTable table(stream.size());
+            std::vector<Vertex> tableVertices;
+            std::vector<uint32_t> tableIndices;
+            tableIndices.reserve(stream.size());
+            for (const Vertex& vertex : stream)
+                tableIndices.push_back(table.insert(vertex, tableVertices));
+            auto tableEnd = std::chrono::high_resolution_clock::now();
+
+            mapTime = std::min(mapTime, std::chrono::duration<float,
+                    std::chrono::milliseconds::period>(mapEnd - mapStart).count());
+            tableTime = std::min(tableTime, std::chrono::duration<float,
+                    std::chrono::milliseconds::period>(tableEnd - mapEnd).count());
+            mapUnique = mapVertices.size();
+            tableUnique = tableVertices.size();
+        }
+        std::cout << stream.size() << " indices: unordered_map " << mapTime << " ms ("
+            << mapUnique << " vertices), MyVertexDedupTable " << tableTime << " ms ("
+            << tableUnique << " vertices), " << mapTime / std::max(tableTime, 0.001f)
+            << "x, best of " << runs << "\n";
+    }
+
+    void writeDeviceCapabilities()
+    {
+        std::ofstream out(DEVICE_CAPABILITIES, std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "failed to write " << DEVICE_CAPABILITIES << "\n";
+            return;
+        }
+        device.getCapabilities().write(out);
     }
 
 private:
 
     void createGameObjects()
     {
-        auto model    = std::make_shared<MyModel>(device, "models/companion_cube.obj");
-        auto texture  = std::make_shared<MyTexture>(device, "textures/companion_cube.png");
-        auto texture2 = std::make_shared<MyTexture>(device, "textures/companion_cube_blue.png");
+        // returns at once, the objects draw placeholders until their assets are uploaded.
+        // every object requests its own assets, the loader hands out the shared copy
+        auto model    = assetLoader->loadModel("models/companion_cube.obj");
+        auto texture  = assetLoader->loadTexture("textures/companion_cube.png");
 
         MyGameObject gameObject = MyGameObject::createGameObject(model, texture);
         gameObjects.push_back(std::move(gameObject));
 
+        model = assetLoader->loadModel("models/companion_cube.obj");
+        auto texture2 = assetLoader->loadTexture("textures/companion_cube_blue.png");
         gameObject = MyGameObject::createGameObject(model, texture2);
         gameObject.transform.translate(glm::vec3(-1.f, -1.f, 2.f));
         gameObject.transform.scale(glm::vec3(0.5f));
         gameObject.transform.rotate(glm::quat({0.f, 1.f, 0.f}));
         gameObjects.push_back(std::move(gameObject));
-        models.push_back(std::move(model));
-        textures.push_back(std::move(texture));
-        textures.push_back(std::move(texture2));
+    }
+
+    void printGeometryStats()
+    {
+        GeometryStoreStats geometryStats = geometryStore.getStats();
+        std::cout << "geometry store: " << geometryStats.vertices.used << "/"
+            << geometryStats.vertices.capacity << " vertices, "
+            << geometryStats.indices.used << "/" << geometryStats.indices.capacity
+            << " indices, fragmentation " << geometryStats.vertices.fragmentation()
+            << "/" << geometryStats.indices.fragmentation() << "\n";
+    }
+
+    void printMemoryStats()
+    {
+        MemoryAllocatorStats memoryStats = device.getMemoryAllocator().getStats();
+        std::cout << "device memory: " << memoryStats.allocations << " allocations in "
+            << memoryStats.blocks << " blocks, " << memoryStats.usedBytes << "/"
+            << memoryStats.blockBytes << " bytes used, fragmentation "
+            << memoryStats.fragmentation() << ", " << memoryStats.dedicatedAllocations
+            << " dedicated (" << memoryStats.dedicatedBytes << " bytes), "
+            << memoryStats.deviceAllocations << "/" << memoryStats.maxDeviceAllocations
+            << " vkAllocateMemory objects\n";
+
+        MemoryBudget budget = device.getMemoryAllocator().getBudget();
+        for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+            const MemoryCategoryStats& category = budget.categories[i];
+            std::cout << "  " << getMemoryCategoryName(static_cast<MemoryCategory>(i)) << ": "
+                << category.bytes << " bytes in " << category.allocations
+                << " allocations, peak " << category.peakBytes << "\n";
+        }
+        for (size_t i = 0; i < budget.heaps.size(); i++) {
+            const MemoryHeapBudget& heap = budget.heaps[i];
+            std::cout << "  heap " << i << (heap.deviceLocal ? " (device local)" : "") << ": "
+                << heap.allocatedBytes << " bytes allocated, peak " << heap.peakBytes
+                << ", usage " << heap.usage << "/" << heap.budget
+                << (budget.queried ? " (VK_EXT_memory_budget)" : " (heap size)") << "\n";
+        }
+    }
+
+    void printUploadStats()
+    {
+        UploadSchedulerStats uploadStats = device.getUploadScheduler().getStats();
+        std::cout << "uploads: " << uploadStats.bytes << " bytes in " << uploadStats.copies
+            << " copies, " << uploadStats.batches << " batches, "
+            << uploadStats.copiesPerBatch() << " copies and "
+            << uploadStats.submissionsPerBatch() << " submissions per batch, "
+            << uploadStats.bytesPerSecond() / (1024.0 * 1024.0) << " MiB/s, "
+            << uploadStats.ringStalls << " ring stalls\n";
+    }
+
+    void printCommandStats()
+    {
+        CommandContextStats commandStats = device.getCommandContextPool().getStats();
+        std::cout << "single commands: " << commandStats.begins << " begun in "
+            << commandStats.buffers << " command buffers, " << commandStats.pools
+            << " pools for " << commandStats.threads << " threads, " << commandStats.resets
+            << " pool resets, " << commandStats.pending << " pending\n";
+    }
+
+    void printAssetStats()
+    {
+        AssetLoaderStats assetStats = assetLoader->getStats();
+        for (auto& [name, registry] : {std::make_pair("models", assetStats.models),
+                std::make_pair("textures", assetStats.textures)})
+        {
+            std::cout << name << ": " << registry.hits << " hits ("
+                << registry.contentHits << " by content), " << registry.misses << " misses, "
+                << registry.residentBytes << " bytes resident, "
+                << registry.savedBytes << " bytes saved\n";
+        }
+        std::cout << "asset loads: " << assetStats.cookedModels << " cooked, "
+            << assetStats.warmModels << " warm, " << assetStats.coldModels
+            << " cold models decoded in " << assetStats.modelDecodeTime << " ms, texture mips "
+            << assetStats.mipTime << " ms, ready after "
+            << assetStats.readyTime / std::max<size_t>(assetStats.loaded, 1)
+            << " ms on average, " << assetStats.maxReadyTime << " ms at most\n";
+    }
+
+    void printStreamingStats()
+    {
+        const TextureStreamingStats& streamingStats = textureStreamer->getStats();
+        std::cout << "texture streaming: " << streamingStats.textures << " textures, "
+            << streamingStats.residentBytes / 1024 << "/" << streamingStats.budget / 1024
+            << " KiB resident, " << streamingStats.pendingUploads << " pending, "
+            << streamingStats.totalPromotions << " promotions, "
+            << streamingStats.totalEvictions << " evictions\n";
+    }
+
+    void printFileStats()
+    {
+        MappedFileStats fileStats = MyMappedFile::getStats();
+        std::cout << "mapped files: " << fileStats.files << " files, "
+            << fileStats.bytes << " bytes mapped\n";
+        if (const MyAssetArchive* archive = getAssetArchive()) {
+            ArchiveStats archiveStats = archive->getStats();
+            std::cout << "asset archive: " << archiveStats.entries << " files, "
+                << archiveStats.compressedEntries << " compressed, " << archiveStats.size
+                << " bytes stored in " << archiveStats.storedSize << "\n";
+        }
+        std::cout << "cooked assets: " << getCookedAssetCount() << " in the manifest\n";
+    }
+
+    void printSamplerStats()
+    {
+        SamplerCacheStats samplerStats = device.getSamplerCache().getStats();
+        std::cout << "samplers: " << samplerStats.samplers << " unique for "
+            << samplerStats.references << " textures, " << samplerStats.created
+            << " created, " << samplerStats.hits << " shared\n";
+    }
+
+    void printPackerStats()
+    {
+        const TexturePackerStats& packerStats = texturePacker->getStats();
+        const DrawStats& drawStats = renderSystem->getDrawStats();
+        std::cout << "texture arrays: " << packerStats.packedTextures << "/"
+            << packerStats.textures << " textures in " << packerStats.arrays << " arrays ("
+            << packerStats.packedFraction() * 100.f << "%), efficiency "
+            << packerStats.efficiency() * 100.f << "%, " << drawStats.textureBinds
+            << " texture binds for " << drawStats.objects << " objects last frame\n";
+        if (descriptorManager.isBindless()) {
+            std::cout << "bindless textures: " << descriptorManager.getBindlessUsed() << "/"
+                << descriptorManager.getBindlessCapacity() << " slots\n";
+        }
     }
 
     void initVulkan() 
     {
+        writeDeviceCapabilities();
         createDescriptorSetLayout();
         createUniformBuffers();
         createDescriptorPool();
-        descriptorManager.createDescriptorSets(renderer.getSize(), textures);
+        descriptorManager.createGlobalDescriptorSets(renderer.getSize());
         updateDescriptorSets();
+        textureStreamer = std::make_unique<MyTextureStreamer>(device, descriptorManager, TEXTURE_BUDGET);
+        assetLoader = std::make_unique<MyAssetLoader>(device, geometryStore, descriptorManager,
+                textureStreamer.get());
+        texturePacker = std::make_unique<MyTexturePacker>(device, descriptorManager,
+                textureStreamer.get());
         renderSystem = std::make_unique<SimpleRenderSystem>(device,
+                geometryStore,
                 renderer.getSwapChainRenderPass(),
                 descriptorManager.getDescriptorSetLayout());
     }
@@ -85,9 +490,12 @@ private:
     {
         std::vector<MyGameObject> cameraHandle = {MyGameObject::createGameObject()};
         cameraHandle[0].transform.translate(camera.getLocation());
+        MyMemoryBudgetLog memoryLog(MEMORY_LOG, MEMORY_LOG_INTERVAL);
 
         while (!window.shouldClose()) {
             glfwPollEvents();
+            assetLoader->update();
+            packTexturesOnceLoaded();
             static auto startTime = std::chrono::high_resolution_clock::now();
             auto currentTime = std::chrono::high_resolution_clock::now();
             float timeDelta = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
@@ -95,22 +503,43 @@ private:
             movementSystem.updateTick(cameraHandle, timeDelta);
             camera.setView(cameraHandle[0].transform.getMatrix());
 
+            textureStreamer->requestLevels(gameObjects, camera, renderer.getSwapChainExtent().height);
+            textureStreamer->update();
+            descriptorManager.update();
+            geometryStore.update();
+            memoryLog.update(device.getMemoryAllocator());
+            const TextureStreamingStats& streamingStats = textureStreamer->getStats();
+            if (streamingStats.promotions || streamingStats.evictions)
+                printStreamingStats();
+
             VkCommandBuffer commandBuffer = renderer.beginFrame();
             renderer.beginRenderPass(commandBuffer);
             updateUniformBuffer(renderer.getIndex());
             renderSystem->renderGameObjects(commandBuffer, gameObjects, 
-                    descriptorManager.getGlobalDescriptorSets(renderer.getIndex()));
+                    descriptorManager.getGlobalDescriptorSets(renderer.getIndex()),
+                    camera);
             renderer.endRenderPass(commandBuffer);
             renderer.endFrame(commandBuffer);
         }
         vkDeviceWaitIdle(device.device);
     }
 
+    // packing copies the textures, do it once they are all resident
+    void packTexturesOnceLoaded()
+    {
+        if (texturesPacked)
+            return;
+        AssetLoaderStats loading = assetLoader->getStats();
+        if (loading.decoding + loading.waiting + loading.uploading > 0)
+            return;
+        texturePacker->pack(gameObjects);
+        texturesPacked = true;
+    }
+
     void cleanupBuffers()
     {
         for (size_t i = 0; i < renderer.getSize(); i++) {
-            vkDestroyBuffer(device.device, uniformBuffers[i], nullptr);
-            vkFreeMemory(device.device, uniformBuffersMemory[i], nullptr);
+            device.destroyBuffer(uniformBuffers[i], uniformBuffersMemory[i]);
         }
     }
 
@@ -121,10 +550,8 @@ private:
         ubo.view = camera.getView();
         ubo.proj = camera.getProjection();
 
-        void* data;
-        vkMapMemory(device.device, uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-        memcpy(data, &ubo, sizeof(ubo));
-        vkUnmapMemory(device.device, uniformBuffersMemory[currentImage]);
+        // host visible memory stays mapped
+        memcpy(uniformBuffersMemory[currentImage].mapped, &ubo, sizeof(ubo));
     }
 
 
@@ -140,6 +567,13 @@ private:
         std::vector<VkDescriptorSetLayoutBinding> globalBindings = {uboLayoutBinding};
         descriptorManager.createGlobalDescriptorSetLayout(globalBindings);
 
+        // one set for all textures, bound once per frame
+        if (device.supportsBindlessTextures()) {
+            descriptorManager.createBindlessTextureTable(
+                    std::min(MAX_BINDLESS_TEXTURES, device.getMaxBindlessTextures()));
+            return;
+        }
+
         VkDescriptorSetLayoutBinding samplerLayoutBinding{};
         samplerLayoutBinding.binding = 0;
         samplerLayoutBinding.descriptorCount = 1;
@@ -163,7 +597,8 @@ private:
                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                     uniformBuffers[i],
-                    uniformBuffersMemory[i]);
+                    uniformBuffersMemory[i],
+                    MemoryCategory::Uniforms);
             updateUniformBuffer(i); //could be called every frame
         }
     }
@@ -174,16 +609,14 @@ private:
         poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         poolSizes[0].descriptorCount = static_cast<uint32_t>(renderer.getSize());
         poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        poolSizes[1].descriptorCount = static_cast<uint32_t>(textures.size());
+        poolSizes[1].descriptorCount = MAX_TEXTURES;
 
         device.createDescriptorPool(poolSizes, 
-                renderer.getSize() * 2);
+                renderer.getSize() + MAX_TEXTURES);
     }
 
     void updateDescriptorSets()
     {
-        descriptorManager.updateTextureDescriptorSets(textures);
-
         std::vector<VkDescriptorBufferInfo> bufferInfos(renderer.getSize(),
                 VkDescriptorBufferInfo{});
 
@@ -234,14 +667,15 @@ public: //TODO perhaps another way, friend?
 private:
     MyWindow window;
     MyDevice device{window};
+    MyGeometryStore geometryStore{device};
     MyRenderer renderer{window, device, 
             device.getMaxUsableSampleCount(),
             static_cast<void*>(this), 
             &HelloTriangleApplication::resizeCallback,
             &HelloTriangleApplication::renderPassUpdateCallback};
+    // outlives every texture, they hand their bindings back to it
+    MyDescriptorManager descriptorManager{device};
     std::vector<MyGameObject> gameObjects{};
-    std::vector<std::shared_ptr<MyTexture>> textures{};
-    std::vector<std::shared_ptr<MyModel>> models{};
     std::unique_ptr<SimpleRenderSystem> renderSystem;
     MyCamera camera{{0.f, 0.f, 5.f},
             MyCamera::calculateAspectRatio(
@@ -249,18 +683,47 @@ private:
                     static_cast<uint32_t>(renderer.getSwapChainExtent().height))
             };
     std::vector<VkBuffer> uniformBuffers;
-    std::vector<VkDeviceMemory> uniformBuffersMemory;
-    MyDescriptorManager descriptorManager{device};
+    std::vector<MemoryAllocation> uniformBuffersMemory;
     MyMovementSystem movementSystem{window.window};
+    // outlives the loader, which hands it textures
+    std::unique_ptr<MyTextureStreamer> textureStreamer;
+    std::unique_ptr<MyAssetLoader> assetLoader;
+    std::unique_ptr<MyTexturePacker> texturePacker;
+    bool texturesPacked = false;
 
 public:
 };
-int main()
+int main(int argc, char** argv)
 {
     HelloTriangleApplication app;
 
     try {
-        app.run();
+        // loose files still load for anything the archive lacks
+        if (std::filesystem::exists(ASSET_ARCHIVE))
+            mountAssetArchive(ASSET_ARCHIVE);
+        // written by make cook, sources it lists load cooked
+        if (MyAssetFile::exists(COOKED_MANIFEST)) {
+            try {
+                loadAssetManifest(COOKED_MANIFEST);
+            } catch (const std::exception& e) {
+                // from an older cook, run make cook again
+                std::cerr << e.what() << ", loading sources\n";
+            }
+        }
+        // Application --texture-bench [count] | --buffer-bench [count] | --obj-bench [file]
+        //     | --dedup-bench [file] | --model-bench [file]
+        if (argc > 1 && strcmp(argv[1], "--texture-bench") == 0)
+            app.benchmarkTextures(argc > 2 ? std::stoul(argv[2]) : 64);
+        else if (argc > 1 && strcmp(argv[1], "--buffer-bench") == 0)
+            app.benchmarkBuffers(argc > 2 ? std::stoul(argv[2]) : 10000);
+        else if (argc > 1 && strcmp(argv[1], "--obj-bench") == 0)
+            app.benchmarkObj(argc > 2 ? argv[2] : BENCHMARK_MODEL);
+        else if (argc > 1 && strcmp(argv[1], "--dedup-bench") == 0)
+            app.benchmarkDedup(argc > 2 ? argv[2] : BENCHMARK_MODEL);
+        else if (argc > 1 && strcmp(argv[1], "--model-bench") == 0)
+            app.benchmarkModel(argc > 2 ? argv[2] : BENCHMARK_MODEL);
+        else
+            app.run();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -0,0 +1,122 @@
+#include "mapped_file.hpp"
+
+//std
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+
+//posix
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// files are mapped on loader workers
+static std::atomic<uint64_t> mappedFiles{0};
+static std::atomic<uint64_t> mappedBytes{0};
+
+MappedView MappedView::subview(size_t offset, size_t length) const
+{
+    offset = std::min(offset, size);
+    return {data + offset, std::min(length, size - offset)};
+}
+
+MappedStreamBuffer::MappedStreamBuffer(MappedView view)
+{
+    // never written through, std::streambuf just has no const get area
+    char* begin = const_cast<char*>(view.data);
+    setg(begin, begin, begin + view.size);
+}
+
+MyMappedFile::MyMappedFile(const std::string& filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open file " + filename + "!");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("failed to stat file " + filename + "!");
+    }
+    fileSize = static_cast<size_t>(st.st_size);
+
+    // mmap refuses empty mappings, an empty file is just an empty view
+    if (fileSize > 0) {
+        mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            close(fd);
+            throw std::runtime_error("failed to map file " + filename + "!");
+        }
+    }
+    // the mapping keeps its own reference to the file
+    close(fd);
+    mappedFiles++;
+    mappedBytes += fileSize;
+}
+
+MyMappedFile::~MyMappedFile()
+{
+    if (mapping)
+        munmap(mapping, fileSize);
+}
+
+const char* MyMappedFile::data() const
+{
+    return static_cast<const char*>(mapping);
+}
+
+size_t MyMappedFile::size() const
+{
+    return fileSize;
+}
+
+MappedView MyMappedFile::view() const
+{
+    return {data(), fileSize};
+}
+
+void MyMappedFile::advise(size_t offset, size_t length, int advice) const
+{
+    if (!mapping || offset >= fileSize)
+        return;
+
+    // the range grows to whole pages
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = offset / pageSize * pageSize;
+    size_t end = offset + std::min(length, fileSize - offset);
+    madvise(static_cast<char*>(mapping) + begin, end - begin, advice);
+}
+
+void MyMappedFile::adviseSequential(size_t offset, size_t length) const
+{
+    advise(offset, length, MADV_SEQUENTIAL);
+}
+
+void MyMappedFile::adviseWillNeed(size_t offset, size_t length) const
+{
+    advise(offset, length, MADV_WILLNEED);
+}
+
+MappedFileStats MyMappedFile::getStats()
+{
+    MappedFileStats stats;
+    stats.files = mappedFiles;
+    stats.bytes = mappedBytes;
+    return stats;
+}
+
+void MyMappedFile::release(size_t offset, size_t length) const
+{
+    if (!mapping || length == 0)
+        return;
+
+    // only whole pages inside the range can be dropped
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+    size_t end = std::min(offset + length, fileSize) / pageSize * pageSize;
+    if (end > begin)
+        madvise(static_cast<char*>(mapping) + begin, end - begin, MADV_DONTNEED);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+//std
+#include <string>
+#include <streambuf>
+#include <cstddef>
+#include <cstdint>
+
+// sizes of the files mapped, whatever their consumers then copied out of
+// the mapping (ktx2 levels are, stb and the mesh cache read in place)
+struct MappedFileStats
+{
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+};
+
+/* * *
+ * Part of a mapping, valid as long as the MyMappedFile it came from.
+ */
+struct MappedView
+{
+    const char* data = nullptr;
+    size_t size = 0;
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    // clamped to the view
+    MappedView subview(size_t offset, size_t length) const;
+};
+
+/* * *
+ * Read-only std::streambuf over a view, for parsers that only take an
+ * std::istream. Reads straight from the mapping.
+ */
+class MappedStreamBuffer : public std::streambuf
+{
+public:
+    MappedStreamBuffer(MappedView view);
+};
+
+/* * *
+ * Read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MyMappedFile
+{
+public:
+    MyMappedFile(const std::string& filename);
+    ~MyMappedFile();
+
+    MyMappedFile(const MyMappedFile& other) = delete;
+    MyMappedFile& operator=(const MyMappedFile& other) = delete;
+
+    const char* data() const;
+    size_t size() const;
+    MappedView view() const;
+
+    // hint that the file, or a range of it, is read front to back
+    void adviseSequential(size_t offset = 0, size_t length = SIZE_MAX) const;
+    // hint that the range is needed soon, starts reading it in
+    void adviseWillNeed(size_t offset = 0, size_t length = SIZE_MAX) const;
+    // drop the pages of a range already consumed, they fault back in on access
+    void release(size_t offset, size_t length) const;
+
+    // totals of every mapping so far, any thread
+    static MappedFileStats getStats();
+
+private:
+    void advise(size_t offset, size_t length, int advice) const;
+
+    void* mapping = nullptr;
+    size_t fileSize = 0;
+};
@@ -0,0 +1,256 @@
+#include "memory_allocator.hpp"
+#include "device.hpp"
+
+//std
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
+
+struct MemoryBlock
+{
+    VkDeviceMemory memory;
+    uint32_t memoryType;
+    VkDeviceSize size;
+    MemoryResource resource;
+    MyRangeAllocator ranges;
+    char* mapped;
+};
+
+const char* getMemoryCategoryName(MemoryCategory category)
+{
+    switch (category) {
+        case MemoryCategory::Geometry:    return "geometry";
+        case MemoryCategory::Textures:    return "textures";
+        case MemoryCategory::Attachments: return "attachments";
+        case MemoryCategory::Uniforms:    return "uniforms";
+        case MemoryCategory::Staging:     return "staging";
+    }
+    return "unknown";
+}
+
+float MemoryAllocatorStats::fragmentation() const
+{
+    VkDeviceSize freeBytes = blockBytes - usedBytes;
+    if (freeBytes == 0)
+        return 0.f;
+    return 1.f - static_cast<float>(largestFreeBytes) / freeBytes;
+}
+
+MyMemoryAllocator::MyMemoryAllocator(MyDevice& device, VkDeviceSize blockSize)
+    : device(device),
+      blockSize(blockSize)
+{
+    memoryProperties = device.getCapabilities().memory;
+    heapBytes.resize(memoryProperties.memoryHeapCount, 0);
+    heapPeakBytes.resize(memoryProperties.memoryHeapCount, 0);
+}
+
+MyMemoryAllocator::~MyMemoryAllocator()
+{
+    size_t leaked = dedicatedAllocations;
+    for (auto& block : blocks) {
+        leaked += block->ranges.getStats().allocations;
+        freeMemory(block->memory, block->memoryType, block->size);
+    }
+    if (leaked > 0)
+        std::cerr << "memory allocator destroyed with " << leaked << " live allocations\n";
+}
+
+VkDeviceSize MyMemoryAllocator::getBlockSize(uint32_t memoryType) const
+{
+    uint32_t heap = memoryProperties.memoryTypes[memoryType].heapIndex;
+    return std::min(blockSize, memoryProperties.memoryHeaps[heap].size / 8);
+}
+
+VkDeviceMemory MyMemoryAllocator::allocateMemory(uint32_t memoryType,
+        VkDeviceSize size,
+        void** mapped)
+{
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device.device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory!");
+    }
+    *mapped = nullptr;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags
+            & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(device.device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+            vkFreeMemory(device.device, memory, nullptr);
+            throw std::runtime_error("failed to map device memory!");
+        }
+    }
+    deviceAllocations++;
+    uint32_t heap = memoryProperties.memoryTypes[memoryType].heapIndex;
+    heapBytes[heap] += size;
+    heapPeakBytes[heap] = std::max(heapPeakBytes[heap], heapBytes[heap]);
+    return memory;
+}
+
+void MyMemoryAllocator::freeMemory(VkDeviceMemory memory, uint32_t memoryType, VkDeviceSize size)
+{
+    // unmapped by vkFreeMemory
+    vkFreeMemory(device.device, memory, nullptr);
+    deviceAllocations--;
+    heapBytes[memoryProperties.memoryTypes[memoryType].heapIndex] -= size;
+}
+
+void MyMemoryAllocator::account(MemoryCategory category, VkDeviceSize size, bool allocated)
+{
+    MemoryCategoryStats& stats = categories[static_cast<size_t>(category)];
+    if (allocated) {
+        stats.bytes += size;
+        stats.allocations++;
+        stats.peakBytes = std::max(stats.peakBytes, stats.bytes);
+    }
+    else {
+        stats.bytes -= size;
+        stats.allocations--;
+    }
+}
+
+MemoryAllocation MyMemoryAllocator::allocate(const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags properties,
+        MemoryResource resource,
+        MemoryCategory category)
+{
+    uint32_t memoryType = device.findMemoryType(requirements.memoryTypeBits, properties);
+    VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[memoryType].propertyFlags;
+    VkDeviceSize alignment = requirements.alignment;
+    VkDeviceSize size = requirements.size;
+    // flushes and invalidates work on whole atoms, neighbours must not share one
+    if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+            && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+    {
+        VkDeviceSize atom = device.getProperties().limits.nonCoherentAtomSize;
+        alignment = std::max(alignment, atom);
+        size = (size + atom - 1) / atom * atom;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryAllocation allocation;
+    allocation.size = size;
+    allocation.memoryType = memoryType;
+    allocation.category = category;
+
+    VkDeviceSize typeBlockSize = getBlockSize(memoryType);
+    if (size > typeBlockSize / 2) {
+        allocation.memory = allocateMemory(memoryType, size, &allocation.mapped);
+        dedicatedAllocations++;
+        dedicatedBytes += size;
+        account(category, size, true);
+        return allocation;
+    }
+
+    for (auto& block : blocks) {
+        if (block->memoryType != memoryType || block->resource != resource)
+            continue;
+        uint64_t offset = block->ranges.allocate(size, alignment);
+        if (offset == MyRangeAllocator::INVALID_OFFSET)
+            continue;
+        allocation.memory = block->memory;
+        allocation.offset = offset;
+        allocation.mapped = block->mapped ? block->mapped + offset : nullptr;
+        allocation.block = block.get();
+        account(category, size, true);
+        return allocation;
+    }
+
+    void* mapped;
+    VkDeviceMemory memory = allocateMemory(memoryType, typeBlockSize, &mapped);
+    blocks.push_back(std::make_unique<MemoryBlock>(MemoryBlock{memory, memoryType, typeBlockSize,
+            resource, MyRangeAllocator(typeBlockSize), static_cast<char*>(mapped)}));
+    MemoryBlock* block = blocks.back().get();
+    allocation.memory = block->memory;
+    allocation.offset = block->ranges.allocate(size, alignment);
+    allocation.mapped = block->mapped ? block->mapped + allocation.offset : nullptr;
+    allocation.block = block;
+    account(category, size, true);
+    return allocation;
+}
+
+void MyMemoryAllocator::free(MemoryAllocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    account(allocation.category, allocation.size, false);
+    if (!allocation.block) {
+        freeMemory(allocation.memory, allocation.memoryType, allocation.size);
+        dedicatedAllocations--;
+        dedicatedBytes -= allocation.size;
+        allocation = MemoryAllocation{};
+        return;
+    }
+
+    MemoryBlock* block = allocation.block;
+    block->ranges.free(allocation.offset);
+    allocation = MemoryAllocation{};
+    if (block->ranges.getStats().allocations > 0)
+        return;
+
+    // an empty block is kept only while it is the last of its kind
+    bool spare = std::any_of(blocks.begin(), blocks.end(), [block](const auto& other) {
+        return other.get() != block && other->memoryType == block->memoryType
+            && other->resource == block->resource;
+    });
+    if (!spare)
+        return;
+    freeMemory(block->memory, block->memoryType, block->size);
+    blocks.erase(std::find_if(blocks.begin(), blocks.end(),
+            [block](const auto& other) { return other.get() == block; }));
+}
+
+MemoryAllocatorStats MyMemoryAllocator::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryAllocatorStats stats;
+    stats.blocks = blocks.size();
+    stats.dedicatedAllocations = dedicatedAllocations;
+    stats.dedicatedBytes = dedicatedBytes;
+    stats.deviceAllocations = deviceAllocations;
+    stats.maxDeviceAllocations = device.getProperties().limits.maxMemoryAllocationCount;
+
+    for (const auto& block : blocks) {
+        RangeAllocatorStats rangeStats = block->ranges.getStats();
+        stats.allocations += rangeStats.allocations;
+        stats.blockBytes += rangeStats.capacity;
+        stats.usedBytes += rangeStats.used;
+        stats.freeRanges += rangeStats.freeBlocks;
+        stats.largestFreeBytes += rangeStats.largestFree;
+    }
+    return stats;
+}
+
+MemoryBudget MyMemoryAllocator::getBudget() const
+{
+    MemoryBudget budget;
+    budget.queried = device.supportsMemoryBudget();
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (budget.queried) {
+        VkPhysicalDeviceMemoryProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties2.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(device.physicalDevice, &properties2);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    budget.categories = categories;
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        MemoryHeapBudget heap;
+        heap.size = memoryProperties.memoryHeaps[i].size;
+        heap.deviceLocal = memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        heap.allocatedBytes = heapBytes[i];
+        heap.peakBytes = heapPeakBytes[i];
+        heap.usage = budget.queried ? budgetProperties.heapUsage[i] : heap.allocatedBytes;
+        heap.budget = budget.queried ? budgetProperties.heapBudget[i] : heap.size;
+        budget.heaps.push_back(heap);
+    }
+    return budget;
+}
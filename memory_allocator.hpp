@@ -0,0 +1,148 @@
+#pragma once
+
+#include "range_allocator.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+class MyDevice;
+struct MemoryBlock;
+
+// buffers and linear images never share a block with optimal images, that
+// keeps them bufferImageGranularity apart without padding every allocation
+enum class MemoryResource
+{
+    Linear,
+    Optimal
+};
+
+// what the memory is used for, only for accounting
+enum class MemoryCategory
+{
+    Geometry,
+    Textures,
+    Attachments,
+    Uniforms,
+    Staging
+};
+static const size_t MEMORY_CATEGORY_COUNT = 5;
+
+const char* getMemoryCategoryName(MemoryCategory category);
+
+struct MemoryAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    uint32_t memoryType = 0;
+    // host visible memory stays mapped while allocated, nullptr otherwise
+    void* mapped = nullptr;
+    // nullptr for dedicated allocations
+    MemoryBlock* block = nullptr;
+    MemoryCategory category = MemoryCategory::Staging;
+};
+
+struct MemoryCategoryStats
+{
+    VkDeviceSize bytes = 0; // of the resources, not of the blocks holding them
+    VkDeviceSize peakBytes = 0;
+    size_t allocations = 0;
+};
+
+struct MemoryHeapBudget
+{
+    VkDeviceSize size = 0;
+    bool deviceLocal = false;
+    VkDeviceSize allocatedBytes = 0; // blocks and dedicated memory of this allocator
+    VkDeviceSize peakBytes = 0;
+    // with VK_EXT_memory_budget the process wide usage and the budget the
+    // driver grants, allocatedBytes and the heap size otherwise
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+};
+
+struct MemoryBudget
+{
+    bool queried = false; // usage and budget come from VK_EXT_memory_budget
+    std::array<MemoryCategoryStats, MEMORY_CATEGORY_COUNT> categories{};
+    std::vector<MemoryHeapBudget> heaps;
+};
+
+struct MemoryAllocatorStats
+{
+    size_t blocks = 0;
+    size_t allocations = 0;          // sub-allocations in blocks
+    size_t dedicatedAllocations = 0;
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize usedBytes = 0;      // of blockBytes
+    VkDeviceSize dedicatedBytes = 0;
+    size_t freeRanges = 0;
+    VkDeviceSize largestFreeBytes = 0; // summed over the blocks
+    // vkAllocateMemory objects alive against maxMemoryAllocationCount
+    uint32_t deviceAllocations = 0;
+    uint32_t maxDeviceAllocations = 0;
+
+    // share of the free block space not in the largest free range of its block
+    float fragmentation() const;
+};
+
+/* * *
+ * Device memory for buffers and images, carved out of large blocks per
+ * memory type instead of one vkAllocateMemory per resource. Each block
+ * places its resources with a best fit MyRangeAllocator at the alignment
+ * they require. Resources larger than half a block get memory of their own.
+ * Host visible blocks are mapped once, for as long as they exist.
+ *
+ * A block that runs empty is released unless it is the last one of its
+ * memory type and resource kind. Every allocation is accounted to a
+ * category and every block to its heap, with peaks. Thread safe.
+ */
+class MyMemoryAllocator
+{
+public:
+    static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;
+
+    // blocks are at most an eighth of their heap
+    MyMemoryAllocator(MyDevice& device, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+    ~MyMemoryAllocator();
+
+    MyMemoryAllocator(const MyMemoryAllocator& other) = delete;
+    MyMemoryAllocator& operator=(const MyMemoryAllocator& other) = delete;
+
+    // throws if no memory type has the properties or memory runs out
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements,
+            VkMemoryPropertyFlags properties,
+            MemoryResource resource,
+            MemoryCategory category);
+    // the resource bound to the allocation has to be destroyed already
+    void free(MemoryAllocation& allocation);
+
+    MemoryAllocatorStats getStats() const;
+    // usage by category and heap, queries the driver budget when supported
+    MemoryBudget getBudget() const;
+
+private:
+    VkDeviceSize getBlockSize(uint32_t memoryType) const;
+    VkDeviceMemory allocateMemory(uint32_t memoryType, VkDeviceSize size, void** mapped);
+    void freeMemory(VkDeviceMemory memory, uint32_t memoryType, VkDeviceSize size);
+    void account(MemoryCategory category, VkDeviceSize size, bool allocated);
+
+    MyDevice& device;
+    VkDeviceSize blockSize;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    std::vector<std::unique_ptr<MemoryBlock>> blocks;
+    size_t dedicatedAllocations = 0;
+    VkDeviceSize dedicatedBytes = 0;
+    uint32_t deviceAllocations = 0;
+    std::array<MemoryCategoryStats, MEMORY_CATEGORY_COUNT> categories{};
+    std::vector<VkDeviceSize> heapBytes;
+    std::vector<VkDeviceSize> heapPeakBytes;
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,56 @@
+#include "memory_budget_log.hpp"
+
+//std
+#include <stdexcept>
+
+MyMemoryBudgetLog::MyMemoryBudgetLog(const std::string& path, float intervalSeconds)
+    : out(path, std::ios::trunc),
+      interval(intervalSeconds),
+      start(std::chrono::steady_clock::now()),
+      last(start)
+{
+    if (!out.is_open()) {
+        throw std::runtime_error("failed to create memory log " + path + "!");
+    }
+}
+
+void MyMemoryBudgetLog::update(const MyMemoryAllocator& allocator)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (headerWritten
+            && std::chrono::duration<float>(now - last).count() < interval)
+        return;
+    write(allocator.getBudget());
+}
+
+void MyMemoryBudgetLog::writeHeader(const MemoryBudget& budget)
+{
+    out << "seconds";
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        const char* name = getMemoryCategoryName(static_cast<MemoryCategory>(i));
+        out << "," << name << "," << name << "_peak";
+    }
+    for (size_t i = 0; i < budget.heaps.size(); i++) {
+        std::string heap = "heap" + std::to_string(i);
+        out << "," << heap << "_allocated," << heap << "_peak," << heap << "_usage,"
+            << heap << "_budget";
+    }
+    out << "\n";
+    headerWritten = true;
+}
+
+void MyMemoryBudgetLog::write(const MemoryBudget& budget)
+{
+    if (!headerWritten)
+        writeHeader(budget);
+    last = std::chrono::steady_clock::now();
+    out << std::chrono::duration<float>(last - start).count();
+    for (const auto& category : budget.categories)
+        out << "," << category.bytes << "," << category.peakBytes;
+    for (const auto& heap : budget.heaps) {
+        out << "," << heap.allocatedBytes << "," << heap.peakBytes << "," << heap.usage
+            << "," << heap.budget;
+    }
+    // complete rows even if the application is killed
+    out << std::endl;
+}
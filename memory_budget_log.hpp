@@ -0,0 +1,38 @@
+#pragma once
+
+#include "memory_allocator.hpp"
+
+//std
+#include <fstream>
+#include <string>
+#include <chrono>
+
+/* * *
+ * Appends a row of MemoryBudget to a CSV file at most once per interval:
+ * time, bytes and peak of every category, then allocated bytes, peak,
+ * usage and budget of every heap. The header is written with the first
+ * row, when the heap count is known.
+ */
+class MyMemoryBudgetLog
+{
+public:
+    // throws if path can not be created
+    MyMemoryBudgetLog(const std::string& path, float intervalSeconds = 1.f);
+
+    MyMemoryBudgetLog(const MyMemoryBudgetLog& other) = delete;
+    MyMemoryBudgetLog& operator=(const MyMemoryBudgetLog& other) = delete;
+
+    // every frame, queries the budget only when a row is due
+    void update(const MyMemoryAllocator& allocator);
+    // a row now, whatever the interval
+    void write(const MemoryBudget& budget);
+
+private:
+    void writeHeader(const MemoryBudget& budget);
+
+    std::ofstream out;
+    float interval;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last;
+    bool headerWritten = false;
+};
@@ -0,0 +1,226 @@
+#include "mesh_cache.hpp"
+#include "vertex.hpp"
+#include "asset_registry.hpp"
+
+//std
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <stdexcept>
+
+static const uint32_t MESH_CACHE_MAGIC = 0x4348534d; // "MSHC"
+static const uint32_t MESH_CACHE_VERSION = 4;
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    uint32_t reserved;
+    uint64_t sourceSize;
+    int64_t  sourceMtime;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t lodOffset;
+    uint64_t meshletOffset;
+    float    boundsMin[3];
+    float    boundsMax[3];
+};
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::string MyMeshCache::cachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+MyMeshCache::MyMeshCache(std::unique_ptr<MyAssetFile> file)
+    : file(std::move(file))
+{
+    header = reinterpret_cast<const MeshCacheHeader*>(this->file->data());
+}
+
+std::unique_ptr<MyMeshCache> MyMeshCache::load(const std::string& sourcePath)
+{
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    if (!statAssetFile(sourcePath, sourceSize, sourceMtime))
+        return nullptr;
+
+    std::unique_ptr<MyAssetFile> file;
+    try {
+        file = std::make_unique<MyAssetFile>(cachePath(sourcePath));
+    } catch (const std::runtime_error&) {
+        return nullptr; // no cache yet
+    }
+    if (!isValid(*file))
+        return nullptr;
+
+    auto header = reinterpret_cast<const MeshCacheHeader*>(file->data());
+    if (header->sourceSize != sourceSize || header->sourceMtime != sourceMtime)
+        return nullptr;
+    return std::unique_ptr<MyMeshCache>(new MyMeshCache(std::move(file)));
+}
+
+std::unique_ptr<MyMeshCache> MyMeshCache::loadCooked(const std::string& path)
+{
+    std::unique_ptr<MyAssetFile> file;
+    try {
+        file = std::make_unique<MyAssetFile>(path);
+    } catch (const std::runtime_error&) {
+        return nullptr; // the manifest lists it but it is gone
+    }
+    if (!isValid(*file))
+        return nullptr;
+    return std::unique_ptr<MyMeshCache>(new MyMeshCache(std::move(file)));
+}
+
+bool MyMeshCache::isValid(const MyAssetFile& file)
+{
+    if (file.size() < sizeof(MeshCacheHeader))
+        return false;
+
+    auto header = reinterpret_cast<const MeshCacheHeader*>(file.data());
+    if (header->magic != MESH_CACHE_MAGIC
+            || header->version != MESH_CACHE_VERSION
+            || header->vertexStride != sizeof(Vertex)
+            || header->lodCount == 0)
+    {
+        return false;
+    }
+
+    uint64_t vertexEnd = header->vertexOffset
+        + static_cast<uint64_t>(header->vertexCount) * sizeof(Vertex);
+    uint64_t indexEnd = header->indexOffset
+        + static_cast<uint64_t>(header->indexCount) * sizeof(uint32_t);
+    uint64_t lodEnd = header->lodOffset
+        + static_cast<uint64_t>(header->lodCount) * sizeof(MeshLod);
+    uint64_t meshletEnd = header->meshletOffset
+        + static_cast<uint64_t>(header->meshletCount) * sizeof(Meshlet);
+    if (vertexEnd > file.size() || indexEnd > file.size()
+            || lodEnd > file.size() || meshletEnd > file.size())
+    {
+        return false;
+    }
+
+    auto lods = reinterpret_cast<const MeshLod*>(file.data() + header->lodOffset);
+    for (uint32_t i = 0; i < header->lodCount; i++) {
+        if (static_cast<uint64_t>(lods[i].firstIndex) + lods[i].indexCount > header->indexCount)
+            return false;
+    }
+    return true;
+}
+
+bool MyMeshCache::store(const std::string& sourcePath,
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        const MeshBounds& bounds,
+        const std::vector<MeshLod>& lods,
+        const std::vector<Meshlet>& meshlets,
+        const std::string& path)
+{
+    MeshCacheHeader header{};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.vertexStride = sizeof(Vertex);
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.meshletCount = static_cast<uint32_t>(meshlets.size());
+    if (!statAssetFile(sourcePath, header.sourceSize, header.sourceMtime))
+        return false;
+    header.vertexOffset = alignUp(sizeof(MeshCacheHeader), 16);
+    header.indexOffset = alignUp(header.vertexOffset + vertices.size() * sizeof(Vertex), 16);
+    header.lodOffset = alignUp(header.indexOffset + indices.size() * sizeof(uint32_t), 16);
+    header.meshletOffset = alignUp(header.lodOffset + lods.size() * sizeof(MeshLod), 16);
+    for (int i = 0; i < 3; i++) {
+        header.boundsMin[i] = bounds.min[i];
+        header.boundsMax[i] = bounds.max[i];
+    }
+
+    // write next to the cache and rename, a reader never sees half a file
+    std::string outputPath = path.empty() ? cachePath(sourcePath) : path;
+    std::string tmpPath = outputPath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "failed to write mesh cache " << outputPath << "\n";
+            return false;
+        }
+        const char padding[16] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding, header.vertexOffset - sizeof(header));
+        out.write(reinterpret_cast<const char*>(vertices.data()),
+                vertices.size() * sizeof(Vertex));
+        out.write(padding, header.indexOffset
+                - (header.vertexOffset + vertices.size() * sizeof(Vertex)));
+        out.write(reinterpret_cast<const char*>(indices.data()),
+                indices.size() * sizeof(uint32_t));
+        out.write(padding, header.lodOffset
+                - (header.indexOffset + indices.size() * sizeof(uint32_t)));
+        out.write(reinterpret_cast<const char*>(lods.data()),
+                lods.size() * sizeof(MeshLod));
+        out.write(padding, header.meshletOffset
+                - (header.lodOffset + lods.size() * sizeof(MeshLod)));
+        out.write(reinterpret_cast<const char*>(meshlets.data()),
+                meshlets.size() * sizeof(Meshlet));
+        if (!out) {
+            std::cerr << "failed to write mesh cache " << outputPath << "\n";
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), outputPath.c_str()) != 0) {
+        std::cerr << "failed to write mesh cache " << outputPath << "\n";
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+const Vertex* MyMeshCache::getVertices() const
+{
+    return reinterpret_cast<const Vertex*>(file->data() + header->vertexOffset);
+}
+
+uint32_t MyMeshCache::getVertexCount() const
+{
+    return header->vertexCount;
+}
+
+const uint32_t* MyMeshCache::getIndices() const
+{
+    return reinterpret_cast<const uint32_t*>(file->data() + header->indexOffset);
+}
+
+uint32_t MyMeshCache::getIndexCount() const
+{
+    return header->indexCount;
+}
+
+MeshBounds MyMeshCache::getBounds() const
+{
+    MeshBounds bounds;
+    bounds.min = {header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]};
+    bounds.max = {header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]};
+    return bounds;
+}
+
+std::vector<MeshLod> MyMeshCache::getLods() const
+{
+    auto lods = reinterpret_cast<const MeshLod*>(file->data() + header->lodOffset);
+    return std::vector<MeshLod>(lods, lods + header->lodCount);
+}
+
+std::vector<Meshlet> MyMeshCache::getMeshlets() const
+{
+    auto meshlets = reinterpret_cast<const Meshlet*>(file->data() + header->meshletOffset);
+    return std::vector<Meshlet>(meshlets, meshlets + header->meshletCount);
+}
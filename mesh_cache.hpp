@@ -0,0 +1,79 @@
+#pragma once
+
+#include "asset_archive.hpp"
+#include "meshlet.hpp"
+
+//libs
+#include <glm/glm.hpp>
+
+//std
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+struct Vertex;
+struct MeshCacheHeader;
+
+struct MeshBounds
+{
+    glm::vec3 min{0.f};
+    glm::vec3 max{0.f};
+};
+
+// one level of detail, a range of the shared index buffer
+struct MeshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.f; // object space distance to the full detail mesh
+};
+
+/* * *
+ * Versioned binary mesh written beside its source model as
+ * "<source>.meshcache". It holds the final vertex and index arrays so a
+ * warm start maps the file and uploads straight from the mapping instead
+ * of parsing the source again. The indices of every level of detail are
+ * stored back to back, with a table of their ranges, followed by the
+ * meshlets of the full detail level. The cache is stale when the source size or
+ * modification time no longer match what was recorded. Cooked meshes
+ * (asset_cook) are the same format written elsewhere and never stale.
+ */
+class MyMeshCache
+{
+public:
+    // nullptr if there is no valid cache for the source
+    static std::unique_ptr<MyMeshCache> load(const std::string& sourcePath);
+    // a cooked mesh, archived or loose. nullptr if it is missing, unreadable
+    // or not a valid cache
+    static std::unique_ptr<MyMeshCache> loadCooked(const std::string& path);
+    // to cachePath(sourcePath) unless a path is given, false if the source
+    // can not be stat'ed or the cache not written
+    static bool store(const std::string& sourcePath,
+            const std::vector<Vertex>& vertices,
+            const std::vector<uint32_t>& indices,
+            const MeshBounds& bounds,
+            const std::vector<MeshLod>& lods,
+            const std::vector<Meshlet>& meshlets,
+            const std::string& path = "");
+    static std::string cachePath(const std::string& sourcePath);
+
+    MyMeshCache(const MyMeshCache& other) = delete;
+    MyMeshCache& operator=(const MyMeshCache& other) = delete;
+
+    const Vertex* getVertices() const;
+    uint32_t getVertexCount() const;
+    const uint32_t* getIndices() const;
+    uint32_t getIndexCount() const;
+    MeshBounds getBounds() const;
+    std::vector<MeshLod> getLods() const;
+    std::vector<Meshlet> getMeshlets() const;
+
+private:
+    MyMeshCache(std::unique_ptr<MyAssetFile> file);
+    // checks the layout, not the source stamp
+    static bool isValid(const MyAssetFile& file);
+
+    std::unique_ptr<MyAssetFile> file;
+    const MeshCacheHeader* header;
+};
@@ -0,0 +1,272 @@
+#include "mesh_optimizer.hpp"
+#include "vertex.hpp"
+
+//libs
+#include <glm/glm.hpp>
+
+//std
+#include <cmath>
+#include <algorithm>
+
+// cache modelled by the Forsyth scoring, larger than the hardware one on purpose
+static const int FORSYTH_CACHE_SIZE = 32;
+static const uint32_t NO_TRIANGLE = ~0u;
+
+static float forsythCacheScore(int position)
+{
+    if (position < 0)
+        return 0.f;
+    // the last triangle's vertices get a fixed score so it is not reused right away
+    if (position < 3)
+        return 0.75f;
+    float scale = 1.f - static_cast<float>(position - 3) / (FORSYTH_CACHE_SIZE - 3);
+    return std::pow(scale, 1.5f);
+}
+
+static float forsythValenceScore(uint32_t remaining)
+{
+    if (remaining == 0)
+        return 0.f;
+    return 2.f / std::sqrt(static_cast<float>(remaining));
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        unsigned cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty() || vertexCount == 0)
+        return stats;
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses followed it
+    std::vector<uint64_t> timestamps(vertexCount, 0);
+    uint64_t time = cacheSize + 1;
+    size_t misses = 0;
+
+    for (uint32_t index : indices) {
+        if (time - timestamps[index] > cacheSize) {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+
+    std::vector<bool> used(vertexCount, false);
+    size_t usedCount = 0;
+    for (uint32_t index : indices) {
+        if (!used[index]) {
+            used[index] = true;
+            usedCount++;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / usedCount;
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // vertex -> triangle adjacency, live triangles are kept at the front of each range
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : indices)
+        liveTriangles[index]++;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (size_t k = 0; k < 3; k++) {
+                uint32_t v = indices[3 * t + k];
+                adjacency[fill[v]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScore[v] = forsythValenceScore(liveTriangles[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = vertexScore[indices[3 * t + 0]]
+            + vertexScore[indices[3 * t + 1]]
+            + vertexScore[indices[3 * t + 2]];
+        if (triangleScore[t] > triangleScore[bestTriangle])
+            bestTriangle = static_cast<uint32_t>(t);
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    while (bestTriangle != NO_TRIANGLE) {
+        const uint32_t* tri = &indices[3 * bestTriangle];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[bestTriangle] = true;
+
+        for (size_t k = 0; k < 3; k++) {
+            uint32_t v = tri[k];
+            uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+            uint32_t* end = begin + liveTriangles[v];
+            uint32_t* it = std::find(begin, end, bestTriangle);
+            std::swap(*it, *(end - 1));
+            liveTriangles[v]--;
+        }
+
+        // the emitted triangle moves to the front of the LRU cache
+        newCache.assign(tri, tri + 3);
+        for (uint32_t v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache.push_back(v);
+        }
+
+        for (size_t i = 0; i < newCache.size(); i++) {
+            uint32_t v = newCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+        }
+
+        bestTriangle = NO_TRIANGLE;
+        float bestScore = -1.f;
+        for (uint32_t v : newCache) {
+            float score = forsythCacheScore(cachePosition[v])
+                + forsythValenceScore(liveTriangles[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+
+            for (uint32_t a = 0; a < liveTriangles[v]; a++) {
+                uint32_t t = adjacency[adjacencyOffsets[v] + a];
+                triangleScore[t] += delta;
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        if (newCache.size() > FORSYTH_CACHE_SIZE)
+            newCache.resize(FORSYTH_CACHE_SIZE);
+        std::swap(cache, newCache);
+
+        // nothing adjacent to the cache is left, restart from the next unused triangle
+        if (bestTriangle == NO_TRIANGLE) {
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                scanCursor++;
+            if (scanCursor < triangleCount)
+                bestTriangle = static_cast<uint32_t>(scanCursor);
+        }
+    }
+
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices,
+        const std::vector<Vertex>& vertices,
+        unsigned cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // a triangle missing the cache on all three vertices starts a new cluster,
+    // reordering whole clusters then costs no extra cache misses inside them
+    std::vector<size_t> clusterStarts;
+    {
+        std::vector<uint64_t> timestamps(vertices.size(), 0);
+        uint64_t time = cacheSize + 1;
+        for (size_t t = 0; t < triangleCount; t++) {
+            int misses = 0;
+            for (size_t k = 0; k < 3; k++) {
+                uint32_t v = indices[3 * t + k];
+                if (time - timestamps[v] > cacheSize) {
+                    timestamps[v] = time++;
+                    misses++;
+                }
+            }
+            if (t == 0 || misses == 3)
+                clusterStarts.push_back(t);
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+    const size_t clusterCount = clusterStarts.size() - 1;
+
+    glm::vec3 meshCentroid{0.f};
+    float meshArea = 0.f;
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3{0.f});
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{0.f});
+
+    for (size_t c = 0; c < clusterCount; c++) {
+        float clusterArea = 0.f;
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+            const glm::vec3& p0 = vertices[indices[3 * t + 0]].pos;
+            const glm::vec3& p1 = vertices[indices[3 * t + 1]].pos;
+            const glm::vec3& p2 = vertices[indices[3 * t + 2]].pos;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            glm::vec3 centroid = (p0 + p1 + p2) / 3.f;
+
+            clusterCentroids[c] += centroid * area;
+            clusterNormals[c] += normal;
+            clusterArea += area;
+        }
+        meshCentroid += clusterCentroids[c];
+        meshArea += clusterArea;
+        if (clusterArea > 0.f)
+            clusterCentroids[c] /= clusterArea;
+    }
+    if (meshArea > 0.f)
+        meshCentroid /= meshArea;
+
+    // clusters facing away from the mesh centre occlude the rest, draw them first
+    std::vector<float> sortKey(clusterCount);
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        float length = glm::length(clusterNormals[c]);
+        sortKey[c] = length > 0.f
+            ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length)
+            : 0.f;
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(),
+            [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (size_t c : order) {
+        result.insert(result.end(),
+                indices.begin() + 3 * clusterStarts[c],
+                indices.begin() + 3 * clusterStarts[c + 1]);
+    }
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(vertices.size(), unused);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (uint32_t& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<uint32_t>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
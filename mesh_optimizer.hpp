@@ -0,0 +1,39 @@
+#pragma once
+
+//std
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+
+struct VertexCacheStats
+{
+    float acmr = 0.f; // transformed vertices per triangle
+    float atvr = 0.f; // transformed vertices per unique vertex
+};
+
+/* * *
+ * Offline-style index/vertex reordering, run once on load before upload.
+ * optimizeVertexCache and optimizeOverdraw only reorder triangles,
+ * optimizeVertexFetch reorders (and drops unused) vertices to follow the
+ * index stream. Run them in that order.
+ */
+
+// simulate a FIFO post-transform cache of cacheSize entries
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        unsigned cacheSize = 16);
+
+// Forsyth's linear-speed vertex cache optimization
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// split the cache-ordered stream into clusters at cache misses and sort
+// the clusters front to back from the outside in, keeping each cluster's
+// cache friendly order
+void optimizeOverdraw(std::vector<uint32_t>& indices,
+        const std::vector<Vertex>& vertices,
+        unsigned cacheSize = 16);
+
+// renumber vertices in order of first use in the index buffer
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
@@ -0,0 +1,280 @@
+#include "mesh_simplifier.hpp"
+#include "vertex.hpp"
+
+//libs
+#include <glm/glm.hpp>
+
+//std
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+
+// plane quadric, error is the weighted mean squared distance to its planes
+struct Quadric
+{
+    float a2 = 0.f, b2 = 0.f, c2 = 0.f, d2 = 0.f;
+    float ab = 0.f, ac = 0.f, ad = 0.f;
+    float bc = 0.f, bd = 0.f, cd = 0.f;
+    float w = 0.f;
+
+    void addPlane(const glm::vec3& n, float d, float weight)
+    {
+        a2 += n.x * n.x * weight; b2 += n.y * n.y * weight;
+        c2 += n.z * n.z * weight; d2 += d * d * weight;
+        ab += n.x * n.y * weight; ac += n.x * n.z * weight; ad += n.x * d * weight;
+        bc += n.y * n.z * weight; bd += n.y * d * weight; cd += n.z * d * weight;
+        w += weight;
+    }
+
+    Quadric& operator+=(const Quadric& o)
+    {
+        a2 += o.a2; b2 += o.b2; c2 += o.c2; d2 += o.d2;
+        ab += o.ab; ac += o.ac; ad += o.ad;
+        bc += o.bc; bd += o.bd; cd += o.cd;
+        w += o.w;
+        return *this;
+    }
+
+    float error(const glm::vec3& p) const
+    {
+        float e = a2 * p.x * p.x + b2 * p.y * p.y + c2 * p.z * p.z
+            + 2.f * (ab * p.x * p.y + ac * p.x * p.z + bc * p.y * p.z)
+            + 2.f * (ad * p.x + bd * p.y + cd * p.z)
+            + d2;
+        return w > 0.f ? std::fabs(e) / w : 0.f;
+    }
+};
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    float cost;
+};
+
+static glm::vec3 triangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+    return glm::cross(p1 - p0, p2 - p0);
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float targetError,
+        float* resultError)
+{
+    const size_t vertexCount = vertices.size();
+    std::vector<uint32_t> result = indices;
+    if (resultError)
+        *resultError = 0.f;
+    if (vertexCount == 0 || result.size() <= targetIndexCount)
+        return result;
+
+    // work in positions scaled to a unit diagonal so errors are relative
+    glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+    glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+    for (const auto& vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.pos);
+        boundsMax = glm::max(boundsMax, vertex.pos);
+    }
+    float extent = glm::length(boundsMax - boundsMin);
+    float scale = extent > 0.f ? 1.f / extent : 1.f;
+
+    std::vector<glm::vec3> positions(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        positions[v] = (vertices[v].pos - boundsMin) * scale;
+
+    // vertices sharing a position map to one canonical vertex
+    std::vector<uint32_t> canonical(vertexCount);
+    std::vector<uint32_t> wedgeCount(vertexCount, 0);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+        auto less = [&vertices](uint32_t a, uint32_t b) {
+            const glm::vec3& pa = vertices[a].pos;
+            const glm::vec3& pb = vertices[b].pos;
+            if (pa.x != pb.x) return pa.x < pb.x;
+            if (pa.y != pb.y) return pa.y < pb.y;
+            if (pa.z != pb.z) return pa.z < pb.z;
+            return a < b;
+        };
+        std::sort(order.begin(), order.end(), less);
+        for (size_t i = 0; i < vertexCount; i++) {
+            if (i > 0 && vertices[order[i]].pos == vertices[order[i - 1]].pos)
+                canonical[order[i]] = canonical[order[i - 1]];
+            else
+                canonical[order[i]] = order[i];
+            wedgeCount[canonical[order[i]]]++;
+        }
+    }
+
+    // seams and open borders stay where they are
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (wedgeCount[canonical[v]] > 1)
+            locked[canonical[v]] = true;
+    }
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(result.size());
+        for (size_t t = 0; t < result.size(); t += 3) {
+            for (size_t k = 0; k < 3; k++) {
+                uint64_t a = canonical[result[t + k]];
+                uint64_t b = canonical[result[t + (k + 1) % 3]];
+                if (a != b)
+                    edges.push_back(a < b ? (a << 32 | b) : (b << 32 | a));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                j++;
+            if (j - i == 1) {
+                locked[edges[i] >> 32] = true;
+                locked[edges[i] & 0xffffffff] = true;
+            }
+            i = j;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < result.size(); t += 3) {
+        const glm::vec3& p0 = positions[result[t + 0]];
+        const glm::vec3& p1 = positions[result[t + 1]];
+        const glm::vec3& p2 = positions[result[t + 2]];
+        glm::vec3 normal = triangleNormal(p0, p1, p2);
+        float length = glm::length(normal);
+        if (length == 0.f)
+            continue;
+        normal = normal / length;
+        float d = -glm::dot(normal, p0);
+        for (size_t k = 0; k < 3; k++)
+            quadrics[canonical[result[t + k]]].addPlane(normal, d, length * 0.5f);
+    }
+
+    const float errorLimit = targetError * targetError;
+    float maxError = 0.f;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    while (result.size() > targetIndexCount) {
+        const size_t triangleCount = result.size() / 3;
+
+        // canonical vertex -> triangles
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : result)
+            adjacencyOffsets[canonical[index] + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++) {
+                for (size_t k = 0; k < 3; k++)
+                    adjacency[fill[canonical[result[3 * t + k]]]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        collapses.clear();
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (size_t k = 0; k < 3; k++) {
+                uint32_t a = result[3 * t + k];
+                uint32_t b = result[3 * t + (k + 1) % 3];
+                uint32_t ca = canonical[a];
+                uint32_t cb = canonical[b];
+                if (ca == cb)
+                    continue;
+
+                Quadric q = quadrics[ca];
+                q += quadrics[cb];
+                if (!locked[ca])
+                    collapses.push_back({a, b, q.error(positions[b])});
+                if (!locked[cb])
+                    collapses.push_back({b, a, q.error(positions[a])});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+        size_t goal = (result.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (const Collapse& collapse : collapses) {
+            if (removed >= goal || collapse.cost > errorLimit)
+                break;
+
+            uint32_t from = canonical[collapse.from];
+            uint32_t to = canonical[collapse.to];
+            if (touched[from] || touched[to])
+                continue;
+
+            // reject collapses that flip any triangle around the moved vertex
+            bool flips = false;
+            size_t collapsedTriangles = 0;
+            for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+                const uint32_t* tri = &result[3 * adjacency[a]];
+                uint32_t c0 = canonical[tri[0]], c1 = canonical[tri[1]], c2 = canonical[tri[2]];
+                if (c0 == to || c1 == to || c2 == to) {
+                    collapsedTriangles++;
+                    continue;
+                }
+                glm::vec3 p[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+                glm::vec3 before = triangleNormal(p[0], p[1], p[2]);
+                for (size_t k = 0; k < 3; k++) {
+                    if (canonical[tri[k]] == from)
+                        p[k] = positions[collapse.to];
+                }
+                glm::vec3 after = triangleNormal(p[0], p[1], p[2]);
+                if (glm::dot(before, after) <= 0.f) {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[to] += quadrics[from];
+            // the one-ring moved as well, leave it for the next pass
+            for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+                const uint32_t* tri = &result[3 * adjacency[a]];
+                for (size_t k = 0; k < 3; k++)
+                    touched[canonical[tri[k]]] = true;
+            }
+            touched[to] = true;
+
+            removed += collapsedTriangles;
+            maxError = std::max(maxError, collapse.cost);
+            applied++;
+        }
+
+        if (applied == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t t = 0; t < triangleCount; t++) {
+            uint32_t i0 = remap[result[3 * t + 0]];
+            uint32_t i1 = remap[result[3 * t + 1]];
+            uint32_t i2 = remap[result[3 * t + 2]];
+            uint32_t c0 = canonical[i0], c1 = canonical[i1], c2 = canonical[i2];
+            if (c0 == c1 || c1 == c2 || c0 == c2)
+                continue;
+            result[write++] = i0;
+            result[write++] = i1;
+            result[write++] = i2;
+        }
+        result.resize(write);
+    }
+
+    if (resultError)
+        *resultError = std::sqrt(maxError);
+    return result;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+//std
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+
+/* * *
+ * Quadric error edge collapse over an existing vertex array. Collapses only
+ * move one vertex onto a neighbouring one, so the result is a new index
+ * buffer into the same vertices and every LOD can share one vertex buffer.
+ * Vertices on open borders and on attribute seams (several vertices at one
+ * position) are kept fixed so the mesh does not tear.
+ *
+ * Errors are distances relative to the mesh bounding box diagonal. The
+ * simplifier stops at targetIndexCount or once the next collapse would
+ * exceed targetError, and reports the largest error it accepted.
+ */
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float targetError,
+        float* resultError = nullptr);
@@ -0,0 +1,171 @@
+#include "meshlet.hpp"
+#include "vertex.hpp"
+
+//std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// a cone this wide is not worth testing
+static const float MIN_CONE_SPREAD = 0.1f;
+
+float MeshletCullStats::culledTriangleFraction() const
+{
+    return triangles > 0 ? static_cast<float>(culledTriangles) / triangles : 0.f;
+}
+
+Frustum extractFrustum(const glm::mat4& transform)
+{
+    auto row = [&transform](int i) {
+        return glm::vec4(transform[0][i], transform[1][i], transform[2][i], transform[3][i]);
+    };
+
+    Frustum frustum;
+    frustum.planes[0] = row(3) + row(0); // left
+    frustum.planes[1] = row(3) - row(0); // right
+    frustum.planes[2] = row(3) + row(1); // top
+    frustum.planes[3] = row(3) - row(1); // bottom
+    frustum.planes[4] = row(2);          // near
+    frustum.planes[5] = row(3) - row(2); // far
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+static void computeBounds(Meshlet& meshlet,
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        const std::vector<uint32_t>& meshletVertices)
+{
+    glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+    glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+    for (uint32_t v : meshletVertices) {
+        boundsMin = glm::min(boundsMin, vertices[v].pos);
+        boundsMax = glm::max(boundsMax, vertices[v].pos);
+    }
+    meshlet.center = (boundsMin + boundsMax) * 0.5f;
+    meshlet.radius = 0.f;
+    for (uint32_t v : meshletVertices)
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[v].pos - meshlet.center));
+
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.triangleCount);
+    glm::vec3 axis{0.f};
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+        const uint32_t* tri = &indices[meshlet.firstIndex + 3 * t];
+        const glm::vec3& p0 = vertices[tri[0]].pos;
+        const glm::vec3& p1 = vertices[tri[1]].pos;
+        const glm::vec3& p2 = vertices[tri[2]].pos;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length == 0.f)
+            continue;
+        normals.push_back(normal / length);
+        axis += normals.back();
+    }
+
+    meshlet.coneAxis = glm::vec3{0.f};
+    meshlet.coneCutoff = 1.f;
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength == 0.f)
+        return;
+    axis /= axisLength;
+
+    float minDot = 1.f;
+    for (const auto& normal : normals)
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    if (minDot <= MIN_CONE_SPREAD)
+        return;
+
+    // sine of the widest normal's angle to the axis
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+}
+
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        uint32_t firstIndex,
+        uint32_t indexCount)
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    meshletVertices.reserve(MESHLET_MAX_VERTICES);
+    // marks vertices of the open meshlet with its number + 1
+    std::vector<uint32_t> owner(vertices.size(), 0);
+
+    Meshlet meshlet;
+    meshlet.firstIndex = firstIndex;
+    auto finish = [&]() {
+        meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+        computeBounds(meshlet, vertices, indices, meshletVertices);
+        meshlets.push_back(meshlet);
+        meshlet = Meshlet{};
+        meshlet.firstIndex = meshlets.back().firstIndex + 3 * meshlets.back().triangleCount;
+        meshletVertices.clear();
+    };
+
+    for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3) {
+        uint32_t tag = static_cast<uint32_t>(meshlets.size()) + 1;
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        size_t newVertices = (owner[a] != tag)
+            + (owner[b] != tag && b != a)
+            + (owner[c] != tag && c != a && c != b);
+
+        if (meshletVertices.size() + newVertices > MESHLET_MAX_VERTICES
+                || meshlet.triangleCount == MESHLET_MAX_TRIANGLES)
+        {
+            finish();
+            tag++;
+        }
+
+        for (size_t k = 0; k < 3; k++) {
+            uint32_t v = indices[i + k];
+            if (owner[v] != tag) {
+                owner[v] = tag;
+                meshletVertices.push_back(v);
+            }
+        }
+        meshlet.triangleCount++;
+    }
+    if (meshlet.triangleCount > 0)
+        finish();
+
+    return meshlets;
+}
+
+void cullMeshlets(const std::vector<Meshlet>& meshlets,
+        const Frustum& frustum,
+        const glm::vec3& cameraPosition,
+        std::vector<uint32_t>& visible,
+        MeshletCullStats* stats)
+{
+    for (uint32_t m = 0; m < meshlets.size(); m++) {
+        const Meshlet& meshlet = meshlets[m];
+
+        bool culled = false;
+        for (const auto& plane : frustum.planes) {
+            if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius) {
+                culled = true;
+                break;
+            }
+        }
+
+        // every triangle faces away if the whole sphere is behind the cone's back side
+        if (!culled) {
+            glm::vec3 toCenter = meshlet.center - cameraPosition;
+            culled = glm::dot(toCenter, meshlet.coneAxis)
+                >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+        }
+
+        if (stats) {
+            stats->meshlets++;
+            stats->triangles += meshlet.triangleCount;
+            if (culled) {
+                stats->culledMeshlets++;
+                stats->culledTriangles += meshlet.triangleCount;
+            }
+        }
+        if (!culled)
+            visible.push_back(m);
+    }
+}
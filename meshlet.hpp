@@ -0,0 +1,68 @@
+#pragma once
+
+//libs
+#include <glm/glm.hpp>
+
+//std
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+
+static const size_t MESHLET_MAX_VERTICES = 64;
+static const size_t MESHLET_MAX_TRIANGLES = 124;
+
+/* * *
+ * A cluster of at most MESHLET_MAX_VERTICES vertices and
+ * MESHLET_MAX_TRIANGLES triangles. Meshlets are cut from the index stream
+ * in order, so each one is a contiguous range of the index buffer and the
+ * visible ones can be drawn straight from it.
+ *
+ * The bounding sphere and normal cone are in model space. A cone cutoff of
+ * 1 means the triangles face too many ways for the cone to cull anything.
+ */
+struct Meshlet
+{
+    glm::vec3 center{0.f};
+    float radius = 0.f;
+    glm::vec3 coneAxis{0.f};
+    float coneCutoff = 1.f;
+    uint32_t firstIndex = 0;
+    uint32_t triangleCount = 0;
+    uint32_t vertexCount = 0;
+};
+
+struct MeshletCullStats
+{
+    size_t meshlets = 0;
+    size_t culledMeshlets = 0;
+    size_t triangles = 0;
+    size_t culledTriangles = 0;
+
+    float culledTriangleFraction() const;
+};
+
+// planes point inwards, xyz normal and w distance
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+// the frustum of clip space (0 to 1 depth) in the space transform maps from
+Frustum extractFrustum(const glm::mat4& transform);
+
+// split indices [firstIndex, firstIndex + indexCount) into meshlets
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        uint32_t firstIndex,
+        uint32_t indexCount);
+
+// append the meshlets that are inside the frustum and not facing away from
+// cameraPosition, in order. Everything is in the meshlets' model space.
+// Stats are added to, not reset.
+void cullMeshlets(const std::vector<Meshlet>& meshlets,
+        const Frustum& frustum,
+        const glm::vec3& cameraPosition,
+        std::vector<uint32_t>& visible,
+        MeshletCullStats* stats = nullptr);
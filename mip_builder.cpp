@@ -0,0 +1,328 @@
+#include "mip_builder.hpp"
+#include "thread_pool.hpp"
+
+//std
+#include <vector>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+//simd
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE2__)
+typedef __m128 Texel;
+static inline Texel zeroTexel() { return _mm_setzero_ps(); }
+static inline Texel loadTexel(const float* p) { return _mm_loadu_ps(p); }
+static inline void storeTexel(float* p, Texel t) { _mm_storeu_ps(p, t); }
+static inline Texel multiplyAdd(Texel acc, Texel t, float w)
+{
+    return _mm_add_ps(acc, _mm_mul_ps(t, _mm_set1_ps(w)));
+}
+#else
+struct Texel { float v[4]; };
+static inline Texel zeroTexel() { return Texel{{0.f, 0.f, 0.f, 0.f}}; }
+static inline Texel loadTexel(const float* p) { return Texel{{p[0], p[1], p[2], p[3]}}; }
+static inline void storeTexel(float* p, Texel t) { memcpy(p, t.v, sizeof(t.v)); }
+static inline Texel multiplyAdd(Texel acc, Texel t, float w)
+{
+    for (int c = 0; c < 4; c++)
+        acc.v[c] += t.v[c] * w;
+    return acc;
+}
+#endif
+
+// texels below this are filtered on the calling thread
+static const uint64_t PARALLEL_TEXELS = 128 * 128;
+// texels per job
+static const uint32_t BAND_TEXELS = 16 * 1024;
+// lookup resolution of linear to sRGB
+static const uint32_t SRGB_TABLE_SIZE = 16384;
+// Kaiser window shape and support in destination texels
+static const float KAISER_ALPHA = 4.f;
+static const float KAISER_RADIUS = 2.f;
+
+static const float* srgbToLinearTable()
+{
+    static const std::vector<float> table = []() {
+        std::vector<float> values(256);
+        for (int i = 0; i < 256; i++) {
+            float c = i / 255.f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+static const uint8_t* linearToSrgbTable()
+{
+    static const std::vector<uint8_t> table = []() {
+        std::vector<uint8_t> values(SRGB_TABLE_SIZE + 1);
+        for (uint32_t i = 0; i <= SRGB_TABLE_SIZE; i++) {
+            float l = static_cast<float>(i) / SRGB_TABLE_SIZE;
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+            values[i] = static_cast<uint8_t>(std::lround(std::clamp(c, 0.f, 1.f) * 255.f));
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// source texels and weights contributing to one destination texel
+struct FilterTaps
+{
+    int32_t first = 0;
+    std::vector<float> weights;
+};
+
+static float besselI0(float x)
+{
+    float sum = 1.f;
+    float term = 1.f;
+    for (int k = 1; k < 16; k++) {
+        term *= (x / (2.f * k)) * (x / (2.f * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static float kaiserSinc(float u)
+{
+    if (std::fabs(u) >= KAISER_RADIUS)
+        return 0.f;
+    float sinc = u == 0.f ? 1.f : std::sin(3.14159265f * u) / (3.14159265f * u);
+    float t = u / KAISER_RADIUS;
+    return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.f - t * t)) / besselI0(KAISER_ALPHA);
+}
+
+static std::vector<FilterTaps> buildTaps(uint32_t srcSize, uint32_t dstSize, MipFilter filter)
+{
+    std::vector<FilterTaps> taps(dstSize);
+    float scale = static_cast<float>(srcSize) / dstSize;
+    for (uint32_t x = 0; x < dstSize; x++) {
+        FilterTaps& tap = taps[x];
+        if (srcSize == dstSize) {
+            tap.first = static_cast<int32_t>(x);
+            tap.weights = {1.f};
+            continue;
+        }
+
+        if (filter == MipFilter::Box) {
+            float begin = x * scale;
+            float end = (x + 1) * scale;
+            tap.first = static_cast<int32_t>(std::floor(begin));
+            int32_t last = static_cast<int32_t>(std::ceil(end)) - 1;
+            for (int32_t i = tap.first; i <= last; i++)
+                tap.weights.push_back(std::min(end, i + 1.f) - std::max(begin, static_cast<float>(i)));
+        }
+        else {
+            float center = (x + 0.5f) * scale;
+            float radius = KAISER_RADIUS * scale;
+            tap.first = static_cast<int32_t>(std::floor(center - radius));
+            int32_t last = static_cast<int32_t>(std::ceil(center + radius));
+            for (int32_t i = tap.first; i <= last; i++)
+                tap.weights.push_back(kaiserSinc((i + 0.5f - center) / scale));
+        }
+
+        float sum = 0.f;
+        for (float w : tap.weights)
+            sum += w;
+        for (float& w : tap.weights)
+            w /= sum;
+    }
+    return taps;
+}
+
+static inline int32_t clampIndex(int32_t i, uint32_t size)
+{
+    return std::clamp(i, 0, static_cast<int32_t>(size) - 1);
+}
+
+static void filterRows(const float* src, uint32_t srcWidth, float* dst, uint32_t dstWidth,
+        const std::vector<FilterTaps>& taps, uint32_t rowBegin, uint32_t rowEnd)
+{
+    for (uint32_t y = rowBegin; y < rowEnd; y++) {
+        const float* srcRow = src + static_cast<size_t>(y) * srcWidth * 4;
+        float* dstRow = dst + static_cast<size_t>(y) * dstWidth * 4;
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            const FilterTaps& tap = taps[x];
+            Texel sum = zeroTexel();
+            for (size_t k = 0; k < tap.weights.size(); k++) {
+                int32_t i = clampIndex(tap.first + static_cast<int32_t>(k), srcWidth);
+                sum = multiplyAdd(sum, loadTexel(srcRow + i * 4), tap.weights[k]);
+            }
+            storeTexel(dstRow + x * 4, sum);
+        }
+    }
+}
+
+static void filterColumns(const float* src, uint32_t srcHeight, float* dst, uint32_t width,
+        const std::vector<FilterTaps>& taps, uint32_t rowBegin, uint32_t rowEnd)
+{
+    std::vector<float> sums(static_cast<size_t>(width) * 4);
+    for (uint32_t y = rowBegin; y < rowEnd; y++) {
+        const FilterTaps& tap = taps[y];
+        std::fill(sums.begin(), sums.end(), 0.f);
+        for (size_t k = 0; k < tap.weights.size(); k++) {
+            int32_t row = clampIndex(tap.first + static_cast<int32_t>(k), srcHeight);
+            const float* srcRow = src + static_cast<size_t>(row) * width * 4;
+            float w = tap.weights[k];
+            for (uint32_t x = 0; x < width; x++)
+                storeTexel(&sums[x * 4], multiplyAdd(loadTexel(&sums[x * 4]), loadTexel(srcRow + x * 4), w));
+        }
+        memcpy(dst + static_cast<size_t>(y) * width * 4, sums.data(), sums.size() * sizeof(float));
+    }
+}
+
+static void toLinear(const uint8_t* src, float* dst, size_t begin, size_t end, bool srgb)
+{
+    const float* table = srgbToLinearTable();
+    for (size_t i = begin; i < end; i++) {
+        for (int c = 0; c < 4; c++) {
+            uint8_t value = src[i * 4 + c];
+            dst[i * 4 + c] = srgb && c < 3 ? table[value] : value / 255.f;
+        }
+    }
+}
+
+static void toBytes(const float* src, uint8_t* dst, size_t begin, size_t end, bool srgb)
+{
+    const uint8_t* table = linearToSrgbTable();
+    for (size_t i = begin; i < end; i++) {
+        for (int c = 0; c < 4; c++) {
+            // Kaiser lobes can overshoot
+            float value = std::clamp(src[i * 4 + c], 0.f, 1.f);
+            if (srgb && c < 3)
+                dst[i * 4 + c] = table[static_cast<uint32_t>(value * SRGB_TABLE_SIZE + 0.5f)];
+            else
+                dst[i * 4 + c] = static_cast<uint8_t>(value * 255.f + 0.5f);
+        }
+    }
+}
+
+// split rows into bands of about BAND_TEXELS and queue fn(begin, end) for each
+static void addBands(std::vector<std::function<void()>>& jobs, uint32_t rows, uint32_t width,
+        const std::function<void(uint32_t, uint32_t)>& fn)
+{
+    uint32_t bandRows = std::max(1u, BAND_TEXELS / std::max(width, 1u));
+    for (uint32_t begin = 0; begin < rows; begin += bandRows) {
+        uint32_t end = std::min(rows, begin + bandRows);
+        jobs.push_back([fn, begin, end]() { fn(begin, end); });
+    }
+}
+
+static void runJobs(std::vector<std::function<void()>>& jobs, MyThreadPool* pool)
+{
+    if (!pool) {
+        for (auto& job : jobs)
+            job();
+    }
+    else {
+        for (auto& job : jobs)
+            pool->submit(std::move(job));
+        pool->wait();
+    }
+    jobs.clear();
+}
+
+void buildMipChain(TextureImage& image, MipFilter filter, unsigned threadCount)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    bool srgb = image.format == VK_FORMAT_R8G8B8A8_SRGB;
+
+    std::vector<TextureLevel> levels;
+    VkDeviceSize total = 0;
+    uint32_t width = image.width;
+    uint32_t height = image.height;
+    while (true) {
+        TextureLevel level;
+        level.width = width;
+        level.height = height;
+        level.offset = (total + 15) / 16 * 16;
+        level.size = static_cast<VkDeviceSize>(width) * height * 4;
+        total = level.offset + level.size;
+        levels.push_back(level);
+        if (width == 1 && height == 1)
+            break;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    // a private pool, wait() then only covers this image's jobs and it is
+    // safe to call from a job of another pool
+    std::unique_ptr<MyThreadPool> pool;
+    if (static_cast<uint64_t>(image.width) * image.height >= PARALLEL_TEXELS && threadCount != 1)
+        pool = std::make_unique<MyThreadPool>(threadCount);
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(total));
+    memcpy(pixels.data(), image.pixels.data(), static_cast<size_t>(levels[0].size));
+
+    std::vector<float> current(static_cast<size_t>(image.width) * image.height * 4);
+    std::vector<float> rows;
+    std::vector<float> next;
+    std::vector<std::function<void()>> jobs;
+    {
+        const uint8_t* src = image.pixels.data();
+        float* dst = current.data();
+        uint32_t levelWidth = image.width;
+        addBands(jobs, image.height, image.width, [=](uint32_t begin, uint32_t end) {
+            toLinear(src, dst, static_cast<size_t>(begin) * levelWidth,
+                    static_cast<size_t>(end) * levelWidth, srgb);
+        });
+        runJobs(jobs, pool.get());
+    }
+
+    for (size_t i = 1; i < levels.size(); i++) {
+        const TextureLevel& src = levels[i - 1];
+        const TextureLevel& dst = levels[i];
+        std::vector<FilterTaps> horizontal = buildTaps(src.width, dst.width, filter);
+        std::vector<FilterTaps> vertical = buildTaps(src.height, dst.height, filter);
+        rows.resize(static_cast<size_t>(dst.width) * src.height * 4);
+        next.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+
+        // the previous level's 8 bit conversion overlaps this level's first pass
+        if (i >= 2) {
+            const float* levelData = current.data();
+            uint8_t* out = pixels.data() + src.offset;
+            uint32_t levelWidth = src.width;
+            addBands(jobs, src.height, src.width, [=](uint32_t begin, uint32_t end) {
+                toBytes(levelData, out, static_cast<size_t>(begin) * levelWidth,
+                        static_cast<size_t>(end) * levelWidth, srgb);
+            });
+        }
+        {
+            const float* in = current.data();
+            float* out = rows.data();
+            addBands(jobs, src.height, dst.width, [=, &horizontal](uint32_t begin, uint32_t end) {
+                filterRows(in, src.width, out, dst.width, horizontal, begin, end);
+            });
+        }
+        runJobs(jobs, pool.get());
+
+        {
+            const float* in = rows.data();
+            float* out = next.data();
+            addBands(jobs, dst.height, dst.width, [=, &vertical](uint32_t begin, uint32_t end) {
+                filterColumns(in, src.height, out, dst.width, vertical, begin, end);
+            });
+        }
+        runJobs(jobs, pool.get());
+        current.swap(next);
+    }
+    if (levels.size() > 1) {
+        const TextureLevel& last = levels.back();
+        toBytes(current.data(), pixels.data() + last.offset, 0,
+                static_cast<size_t>(last.width) * last.height, srgb);
+    }
+
+    image.levels = std::move(levels);
+    image.pixels = std::move(pixels);
+    image.mipTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+}
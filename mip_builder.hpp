@@ -0,0 +1,24 @@
+#pragma once
+
+#include "texture.hpp"
+
+enum class MipFilter
+{
+    Box,    // average of the covered source texels
+    Kaiser  // Kaiser windowed sinc, sharper minification
+};
+
+/* * *
+ * Builds the full mip chain of an RGBA8 image on the cpu. image has to hold
+ * only its top level (no levels). Afterwards it holds every level, level 0
+ * first, and uploads through the precomputed level path in one staging
+ * copy. For R8G8B8A8_SRGB images color is filtered in linear space, alpha
+ * always is.
+ *
+ * The filter is separable and runs on float4 texels with SSE2 where
+ * available. Rows of a level are split into bands filtered in parallel,
+ * and the 8 bit conversion of one level runs alongside the filtering of
+ * the next. threadCount 0 uses one thread per hardware thread, small
+ * images are filtered on the calling thread.
+ */
+void buildMipChain(TextureImage& image, MipFilter filter = MipFilter::Kaiser, unsigned threadCount = 0);
@@ -1,6 +1,11 @@
 #include "model.hpp"
 #include "vertex.hpp"
-#include "device.hpp"
+#include "obj_loader.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "upload_scheduler.hpp"
+#include "asset_archive.hpp"
+#include "asset_manifest.hpp"
     
 //libs
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -8,50 +13,315 @@
 
 //std
 #include <map>
-#include <unordered_map>
-#include <iostream>
+#include <chrono>
+#include <limits>
+#include <filesystem>
+#include <istream>
+#include <cstring>
 
-MyModel::MyModel(MyDevice& device, const char* modelPath)
-    :device(device)
+// files at least this large go through the multi-threaded reader
+static const uintmax_t PARALLEL_OBJ_BYTES = 8 * 1024 * 1024;
+
+// each level halves the triangles of the one before, within a growing error budget
+static const std::vector<LodLevel> DEFAULT_LOD_LEVELS = {
+    {0.5f, 0.002f},
+    {0.5f, 0.005f},
+    {0.5f, 0.01f},
+    {0.5f, 0.02f},
+};
+
+// stop the chain once a level removes less than this share of triangles
+static const float MIN_LOD_REDUCTION = 0.1f;
+
+const char* getModelSourceName(ModelSource source)
 {
-    loadModel(modelPath);
-    createVertexBuffer();
-    createIndexBuffer();
+    switch (source) {
+        case ModelSource::None:      return "built";
+        case ModelSource::Cooked:    return "cooked";
+        case ModelSource::MeshCache: return "warm, mesh cache";
+        case ModelSource::Obj:       return "cold, obj";
+    }
+    return "unknown";
+}
+
+MyModel::MyModel(MyGeometryStore& geometry, const char* modelPath)
+    :geometry(&geometry)
+{
+    decode(modelPath);
+    upload();
 }
 
+MyModel::MyModel(MyGeometryStore& geometry,
+        std::vector<Vertex> vertices,
+        std::vector<uint32_t> indices)
+    :geometry(&geometry),
+     vertices(std::move(vertices)),
+     indices(std::move(indices))
+{
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : this->vertices) {
+        bounds.min = glm::min(bounds.min, vertex.pos);
+        bounds.max = glm::max(bounds.max, vertex.pos);
+    }
+    lods.push_back({0, static_cast<uint32_t>(this->indices.size()), 0.f});
+    meshlets = ::buildMeshlets(this->vertices, this->indices, 0, lods[0].indexCount);
+    upload();
+}
+
+MyModel::MyModel(MyGeometryStore& geometry)
+    :geometry(&geometry)
+{ }
+
+MyModel::MyModel()
+    :geometry(nullptr)
+{ }
+
 MyModel::~MyModel()
 {
-    vkDestroyBuffer(device.device, vertexBuffer, nullptr);
-    vkFreeMemory(device.device, vertexBufferMemory, nullptr);
-    vkDestroyBuffer(device.device, indexBuffer, nullptr);
-    vkFreeMemory(device.device, indexBufferMemory, nullptr);
+    if (resident)
+        geometry->free(allocation);
 }
 
-void MyModel::bind(VkCommandBuffer& commandBuffer) const
+void MyModel::decode(const char* modelPath)
 {
-    VkBuffer vertexBuffers[] = {vertexBuffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    const ManifestEntry* cooked = findCookedAsset(modelPath);
+    meshCache = cooked ? MyMeshCache::loadCooked(cooked->cooked) : nullptr;
+    if (meshCache) {
+        useMeshCache();
+        loadStats.source = ModelSource::Cooked;
+    }
+    else if (loadCachedModel(modelPath))
+        loadStats.source = ModelSource::MeshCache;
+    else {
+        build(modelPath);
+        writeCachedModel(modelPath);
+        loadStats.source = ModelSource::Obj;
+    }
+    loadStats.loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - loadStart).count();
+}
+
+void MyModel::build(const char* modelPath)
+{
+    loadModel(modelPath);
+    optimizeMesh();
+    buildLods(DEFAULT_LOD_LEVELS);
+    buildMeshlets();
+}
+
+void MyModel::draw(VkCommandBuffer& commandBuffer, uint32_t lod) const
+{
+    const MeshLod& level = lods[lod];
+    vkCmdDrawIndexed(commandBuffer, level.indexCount, 1,
+            allocation.firstIndex + level.firstIndex,
+            static_cast<int32_t>(allocation.vertexOffset), 0);
+}
+
+void MyModel::drawMeshlets(VkCommandBuffer& commandBuffer,
+        const std::vector<uint32_t>& visible) const
+{
+    // meshlets are consecutive index ranges, neighbours go out as one draw
+    for (size_t i = 0; i < visible.size();) {
+        uint32_t firstIndex = meshlets[visible[i]].firstIndex;
+        uint32_t indexCount = 0;
+        size_t j = i;
+        do {
+            indexCount += 3 * meshlets[visible[j]].triangleCount;
+            j++;
+        } while (j < visible.size() && visible[j] == visible[j - 1] + 1);
+        vkCmdDrawIndexed(commandBuffer, indexCount, 1,
+                allocation.firstIndex + firstIndex,
+                static_cast<int32_t>(allocation.vertexOffset), 0);
+        i = j;
+    }
 }
 
-void MyModel::draw(VkCommandBuffer& commandBuffer) const
+MeshBounds MyModel::getBounds() const
 {
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+    return bounds;
+}
+
+uint32_t MyModel::getLodCount() const
+{
+    return static_cast<uint32_t>(lods.size());
+}
+
+const MeshLod& MyModel::getLod(uint32_t lod) const
+{
+    return lods[lod];
+}
+
+uint32_t MyModel::getLodTriangleCount(uint32_t lod) const
+{
+    return lods[lod].indexCount / 3;
+}
+
+float MyModel::getSimplifyTime() const
+{
+    return loadStats.simplifyTime;
+}
+
+const ModelLoadStats& MyModel::getLoadStats() const
+{
+    return loadStats;
+}
+
+const std::vector<Meshlet>& MyModel::getMeshlets() const
+{
+    return meshlets;
+}
+
+const Vertex* MyModel::getVertexData() const
+{
+    return meshCache ? meshCache->getVertices() : vertices.data();
+}
+
+uint32_t MyModel::getVertexCount() const
+{
+    return meshCache ? meshCache->getVertexCount() : static_cast<uint32_t>(vertices.size());
+}
+
+const uint32_t* MyModel::getIndexData() const
+{
+    return meshCache ? meshCache->getIndices() : indices.data();
+}
+
+uint32_t MyModel::getIndexCount() const
+{
+    return meshCache ? meshCache->getIndexCount() : static_cast<uint32_t>(indices.size());
+}
+
+bool MyModel::loadCachedModel(const char* modelPath)
+{
+    meshCache = MyMeshCache::load(modelPath);
+    if (!meshCache)
+        return false;
+    useMeshCache();
+    return true;
+}
+
+void MyModel::useMeshCache()
+{
+    bounds = meshCache->getBounds();
+    lods = meshCache->getLods();
+    meshlets = meshCache->getMeshlets();
+    loadStats.vertices = meshCache->getVertexCount();
+}
+
+bool MyModel::writeCachedModel(const char* modelPath, const std::string& cachePath)
+{
+    return MyMeshCache::store(modelPath, vertices, indices, bounds, lods, meshlets, cachePath);
 }
 
 void MyModel::loadModel(const char* modelPath)
+{
+    if (MyAssetFile::getSize(modelPath) >= PARALLEL_OBJ_BYTES) {
+        loadObjParallel(modelPath, vertices, indices, 0, &loadStats.parallelParse);
+    }
+    else {
+        auto start = std::chrono::high_resolution_clock::now();
+        loadObjSerial(modelPath);
+        loadStats.serialParseTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices) {
+        bounds.min = glm::min(bounds.min, vertex.pos);
+        bounds.max = glm::max(bounds.max, vertex.pos);
+    }
+    loadStats.vertices = static_cast<uint32_t>(vertices.size());
+}
+
+void MyModel::optimizeMesh()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    VertexCacheStats before = analyzeVertexCache(indices, vertices.size());
+
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+
+    VertexCacheStats after = analyzeVertexCache(indices, vertices.size());
+    loadStats.optimizeTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+    loadStats.acmrBefore = before.acmr;
+    loadStats.acmrAfter = after.acmr;
+}
+
+void MyModel::buildLods(const std::vector<LodLevel>& levels)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    const uint32_t fullIndexCount = static_cast<uint32_t>(indices.size());
+    const float extent = glm::length(bounds.max - bounds.min);
+
+    lods.clear();
+    lods.push_back({0, fullIndexCount, 0.f});
+
+    // every level is appended to the one index buffer and indexes the shared vertices
+    std::vector<uint32_t> previous(indices.begin(), indices.end());
+    float previousError = 0.f;
+    for (const auto& level : levels) {
+        size_t targetIndexCount = static_cast<size_t>(previous.size() * level.indexRatio) / 3 * 3;
+        float error = 0.f;
+        std::vector<uint32_t> lodIndices = simplifyMesh(vertices, previous,
+                targetIndexCount, level.targetError, &error);
+        if (lodIndices.empty()
+                || lodIndices.size() > previous.size() * (1.f - MIN_LOD_REDUCTION))
+            break;
+
+        optimizeVertexCache(lodIndices, vertices.size());
+        // errors of consecutive levels add up, keep the bound conservative
+        previousError += error;
+        lods.push_back({static_cast<uint32_t>(indices.size()),
+                static_cast<uint32_t>(lodIndices.size()),
+                previousError * extent});
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        previous.swap(lodIndices);
+    }
+
+    loadStats.simplifyTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void MyModel::buildMeshlets()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    meshlets = ::buildMeshlets(vertices, indices, lods[0].firstIndex, lods[0].indexCount);
+    loadStats.meshletTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void MyModel::loadObjSerial(const char* modelPath)
 {
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
     std::string warn, err;
 
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelPath)) {
+    // parse straight from the mapping, materials still load from next to the file
+    MyAssetFile file(modelPath);
+    file.adviseSequential();
+    MappedStreamBuffer buffer(file.view());
+    std::istream stream(&buffer);
+    std::string baseDir = std::filesystem::path(modelPath).parent_path().string();
+    tinyobj::MaterialFileReader materialReader(baseDir.empty() ? "" : baseDir + "/");
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream, &materialReader)) {
         throw std::runtime_error(warn + err);
     }
 
-    std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+    size_t indexCount = 0;
+    for (const auto& shape : shapes) {
+        indexCount += shape.mesh.indices.size();
+    }
+    indices.reserve(indexCount);
+
+    // every index could be a unique vertex, so this never rehashes
+    auto dedupStart = std::chrono::high_resolution_clock::now();
+    MyVertexDedupTable uniqueVertices(indexCount);
 
     for (const auto& shape : shapes) {
         for (const auto& index : shape.mesh.indices) {
@@ -68,72 +338,44 @@ void MyModel::loadModel(const char* modelPath)
                 1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
             };
 
-            if (uniqueVertices.count(vertex) == 0) {
-                uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                vertices.push_back(vertex);
-            }
-            indices.push_back(uniqueVertices[vertex]);
+            indices.push_back(uniqueVertices.insert(vertex, vertices));
         }
     }
-    std::cout << "model vertex count: " << vertices.size() << " - size: " << sizeof(vertices) << "\n";
-}
-
-void MyModel::createVertexBuffer()
-{
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    device.createBuffer(
-            bufferSize, 
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer, 
-            stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device.device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device.device, stagingBufferMemory);
-
-    device.createBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            vertexBuffer,
-            vertexBufferMemory);
-
-    device.copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
-    vkDestroyBuffer(device.device, stagingBuffer, nullptr);
-    vkFreeMemory(device.device, stagingBufferMemory, nullptr);
-}
-
-void MyModel::createIndexBuffer()
-{
-    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    device.createBuffer(
-            bufferSize, 
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer, 
-            stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device.device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device.device, stagingBufferMemory);
-
-    device.createBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            indexBuffer,
-            indexBufferMemory);
-
-    device.copyBuffer(stagingBuffer, indexBuffer, bufferSize);
-    vkDestroyBuffer(device.device, stagingBuffer, nullptr);
-    vkFreeMemory(device.device, stagingBufferMemory, nullptr);
+    loadStats.dedupTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - dedupStart).count();
+}
+
+void MyModel::upload()
+{
+    allocation = geometry->allocate(getVertexData(), getVertexCount(),
+            getIndexData(), getIndexCount());
+    resident = true;
+    releaseCpuData();
+}
+
+VkDeviceSize MyModel::getUploadSize() const
+{
+    return sizeof(Vertex) * static_cast<VkDeviceSize>(getVertexCount())
+        + sizeof(uint32_t) * static_cast<VkDeviceSize>(getIndexCount());
+}
+
+void MyModel::recordUpload(MyUploadScheduler& uploads)
+{
+    allocation = geometry->allocate(getVertexCount(), getIndexCount());
+    resident = true;
+
+    StagingRange staging = uploads.stage(getUploadSize());
+    char* dst = static_cast<char*>(staging.data);
+    size_t vertexSize = sizeof(Vertex) * getVertexCount();
+    memcpy(dst, getVertexData(), vertexSize);
+    memcpy(dst + vertexSize, getIndexData(), sizeof(uint32_t) * getIndexCount());
+    geometry->recordUpload(uploads, allocation,
+            staging.buffer, staging.offset);
+}
+
+void MyModel::releaseCpuData()
+{
+    std::vector<Vertex>().swap(vertices);
+    std::vector<uint32_t>().swap(indices);
+    meshCache.reset();
 }
@@ -1,35 +1,125 @@
 #pragma once
 
+#include "mesh_cache.hpp"
+#include "geometry_store.hpp"
+#include "obj_loader.hpp"
+
 //libs
 #include <vulkan/vulkan.h>
 
 //std
 #include <vector>
+#include <string>
 #include <cstdint>
+#include <memory>
+
+struct Vertex;
+class MyUploadScheduler;
+
+// one simplified level, relative to the level before it
+struct LodLevel
+{
+    float indexRatio;  // target index count as a fraction of the previous level
+    float targetError; // max error as a fraction of the model's extent
+};
+
+// where decode took a model's data from
+enum class ModelSource
+{
+    None,      // not decoded, built from geometry given
+    Cooked,    // asset_cook mesh listed in the manifest
+    MeshCache, // warm, the cache beside the source
+    Obj        // cold, parsed and processed
+};
+
+const char* getModelSourceName(ModelSource source);
 
-class Vertex;
-class MyDevice;
+// the cpu side of one model's load, times in ms. Steps that did not run stay 0
+struct ModelLoadStats
+{
+    ModelSource source = ModelSource::None;
+    float loadTime = 0.f;        // all of decode
+    uint32_t vertices = 0;
+    ObjLoadStats parallelParse;  // large files only
+    float serialParseTime = 0.f; // tinyobjloader and dedup
+    float dedupTime = 0.f;
+    float optimizeTime = 0.f;
+    float acmrBefore = 0.f;
+    float acmrAfter = 0.f;
+    float simplifyTime = 0.f;
+    float meshletTime = 0.f;
+};
 
 class MyModel {
 public:
-    MyModel(MyDevice& device, const char* modelPath);
+    // load and upload, blocking
+    MyModel(MyGeometryStore& geometry, const char* modelPath);
+    // upload in-memory geometry as a single LOD, blocking
+    MyModel(MyGeometryStore& geometry,
+            std::vector<Vertex> vertices,
+            std::vector<uint32_t> indices);
+    // empty, filled in by decode and upload/recordUpload
+    MyModel(MyGeometryStore& geometry);
+    // cpu side only, for offline cooking, can not be uploaded
+    MyModel();
     ~MyModel();
 
     MyModel(MyModel& other) = delete;
     MyModel operator=(MyModel& other) = delete;
 
+    // cpu side only (parse, optimize, LODs, cache), safe on a worker thread.
+    // Takes the cooked mesh if the asset manifest lists one
+    void decode(const char* modelPath);
+    // parse and process the source, whatever caches exist
+    void build(const char* modelPath);
+    bool loadCachedModel(const char* modelPath);
+    // beside the source unless a cache path is given, false if not written
+    bool writeCachedModel(const char* modelPath, const std::string& cachePath = "");
     void loadModel(const char* modelPath);
-    void createVertexBuffer();
-    void createIndexBuffer();
-    void bind(VkCommandBuffer& commandBuffer) const;
-    void draw(VkCommandBuffer& commandBuffer) const;
+    // tinyobjloader on this thread, what loadObjParallel is measured against
+    void loadObjSerial(const char* modelPath);
+    void optimizeMesh();
+    void buildLods(const std::vector<LodLevel>& levels);
+    void buildMeshlets();
+    void upload();
+    VkDeviceSize getUploadSize() const;
+    // reserve geometry, stage the data and record the copy into the current
+    // batch, the model is drawable once that batch completed
+    void recordUpload(MyUploadScheduler& uploads);
+    // drop the cpu copy of vertices and indices after the upload completed
+    void releaseCpuData();
+    // the geometry store has to be bound
+    void draw(VkCommandBuffer& commandBuffer, uint32_t lod = 0) const;
+    // draw the listed meshlets of the full detail level, visible must be ascending
+    void drawMeshlets(VkCommandBuffer& commandBuffer, const std::vector<uint32_t>& visible) const;
+
+    MeshBounds getBounds() const;
+    uint32_t getLodCount() const;
+    const MeshLod& getLod(uint32_t lod) const;
+    uint32_t getLodTriangleCount(uint32_t lod) const;
+    // 0 when the LODs came from the mesh cache
+    float getSimplifyTime() const;
+    // filled in by decode and the steps of build
+    const ModelLoadStats& getLoadStats() const;
+    const std::vector<Meshlet>& getMeshlets() const;
+    // vertex/index data lives in the mesh cache mapping on warm starts
+    const Vertex* getVertexData() const;
+    uint32_t getVertexCount() const;
+    const uint32_t* getIndexData() const;
+    uint32_t getIndexCount() const;
 
 private:
-    MyDevice& device;
+    // bounds, lods and meshlets from meshCache
+    void useMeshCache();
+
+    MyGeometryStore* geometry;
+    GeometryAllocation allocation;
+    bool resident = false;
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
-    VkBuffer vertexBuffer;
-    VkBuffer indexBuffer;
-    VkDeviceMemory vertexBufferMemory;
-    VkDeviceMemory indexBufferMemory;
+    std::unique_ptr<MyMeshCache> meshCache;
+    MeshBounds bounds;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    ModelLoadStats loadStats;
 };
@@ -0,0 +1,331 @@
+#include "obj_loader.hpp"
+#include "asset_archive.hpp"
+#include "vertex.hpp"
+#include "thread_pool.hpp"
+
+//std
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <charconv>
+#include <exception>
+
+// bytes handed to each thread per window
+static const size_t CHUNK_BYTES = 8 * 1024 * 1024;
+
+struct ObjIndex
+{
+    int64_t value = 0;
+    bool relative = false; // value is relative to the chunk's first element
+    bool present = false;
+};
+
+struct ObjCorner
+{
+    ObjIndex position;
+    ObjIndex texCoord;
+};
+
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<ObjCorner> corners; // three per triangle
+    std::vector<Vertex> vertices;   // corners resolved during merge
+    std::exception_ptr error;       // thrown by its parse or resolve job
+};
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void skipSpace(const char*& p, const char* end)
+{
+    while (p < end && isSpace(*p))
+        p++;
+}
+
+static const char* nextLine(const char* p, const char* end)
+{
+    while (p < end && *p != '\n')
+        p++;
+    return p < end ? p + 1 : end;
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// correctly rounded, 0 for a missing or malformed number
+static float parseFloat(const char*& p, const char* end)
+{
+    skipSpace(p, end);
+    // from_chars takes a minus sign only
+    if (p < end && *p == '+')
+        p++;
+
+    // an out of range number is skipped and left 0
+    float value = 0.f;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc::invalid_argument)
+        p = result.ptr;
+    return value;
+}
+
+static ObjIndex parseIndex(const char*& p, const char* end, size_t localCount)
+{
+    ObjIndex index;
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p >= end || !isDigit(*p))
+        return index;
+
+    int64_t value = 0;
+    while (p < end && isDigit(*p))
+        value = value * 10 + (*p++ - '0');
+
+    index.present = true;
+    if (negative) {
+        index.relative = true;
+        index.value = static_cast<int64_t>(localCount) - value;
+    }
+    else {
+        index.value = value - 1;
+    }
+    return index;
+}
+
+static void parseFace(const char* p, const char* end, ObjChunk& chunk)
+{
+    // corners of the polygon, fan triangulated as they come in
+    ObjCorner first, previous;
+    size_t cornerCount = 0;
+
+    while (true) {
+        skipSpace(p, end);
+        if (p >= end || *p == '\n' || *p == '#')
+            break;
+
+        ObjCorner corner;
+        corner.position = parseIndex(p, end, chunk.positions.size() / 3);
+        if (p < end && *p == '/') {
+            p++;
+            corner.texCoord = parseIndex(p, end, chunk.texCoords.size() / 2);
+            if (p < end && *p == '/') {
+                p++;
+                parseIndex(p, end, 0); // normals are not used
+            }
+        }
+        if (!corner.position.present)
+            throw std::runtime_error("malformed obj face!");
+
+        if (cornerCount == 0) {
+            first = corner;
+        }
+        else if (cornerCount >= 2) {
+            chunk.corners.push_back(first);
+            chunk.corners.push_back(previous);
+            chunk.corners.push_back(corner);
+        }
+        previous = corner;
+        cornerCount++;
+
+        while (p < end && !isSpace(*p) && *p != '\n')
+            p++;
+    }
+}
+
+static void parseChunk(ObjChunk& chunk)
+{
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+
+    while (p < end) {
+        const char* line = p;
+        p = nextLine(p, end);
+        skipSpace(line, p);
+
+        if (p - line < 2)
+            continue;
+
+        if (line[0] == 'v' && isSpace(line[1])) {
+            const char* q = line + 1;
+            chunk.positions.push_back(parseFloat(q, p));
+            chunk.positions.push_back(parseFloat(q, p));
+            chunk.positions.push_back(parseFloat(q, p));
+        }
+        else if (line[0] == 'v' && line[1] == 't' && p - line > 2 && isSpace(line[2])) {
+            const char* q = line + 2;
+            chunk.texCoords.push_back(parseFloat(q, p));
+            chunk.texCoords.push_back(parseFloat(q, p));
+        }
+        else if (line[0] == 'f' && isSpace(line[1])) {
+            parseFace(line + 1, p, chunk);
+        }
+    }
+}
+
+static int64_t resolve(const ObjIndex& index, size_t base, size_t total)
+{
+    int64_t value = index.relative ? static_cast<int64_t>(base) + index.value : index.value;
+    if (value < 0 || value >= static_cast<int64_t>(total))
+        throw std::runtime_error("obj face references a missing vertex!");
+    return value;
+}
+
+static void resolveChunk(ObjChunk& chunk,
+        size_t positionBase,
+        size_t texCoordBase,
+        const std::vector<float>& positions,
+        const std::vector<float>& texCoords)
+{
+    size_t positionCount = positions.size() / 3;
+    size_t texCoordCount = texCoords.size() / 2;
+
+    chunk.vertices.resize(chunk.corners.size());
+    for (size_t i = 0; i < chunk.corners.size(); i++) {
+        const ObjCorner& corner = chunk.corners[i];
+        Vertex vertex{};
+
+        int64_t p = resolve(corner.position, positionBase, positionCount);
+        vertex.pos = {positions[3 * p + 0], positions[3 * p + 1], positions[3 * p + 2]};
+
+        if (corner.texCoord.present) {
+            int64_t t = resolve(corner.texCoord, texCoordBase, texCoordCount);
+            vertex.texCoord = {texCoords[2 * t + 0], 1.0f - texCoords[2 * t + 1]};
+        }
+        else {
+            vertex.texCoord = {0.f, 1.f};
+        }
+
+        chunk.vertices[i] = vertex;
+    }
+}
+
+// first line start at or after p
+static const char* alignToLine(const char* p, const char* begin, const char* end)
+{
+    if (p <= begin || p >= end)
+        return std::min(std::max(p, begin), end);
+    if (p[-1] == '\n')
+        return p;
+    return nextLine(p, end);
+}
+
+void loadObjParallel(const std::string& filename,
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        unsigned threadCount,
+        ObjLoadStats* stats)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    MyAssetFile file(filename);
+    file.adviseSequential();
+
+    const char* fileBegin = file.data();
+    const char* fileEnd = file.data() + file.size();
+    const size_t windowBytes = CHUNK_BYTES * threadCount;
+
+    // positions and texcoords stay for the whole file, faces may use any of them
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    MyVertexDedupTable uniqueVertices(file.size() / 32);
+
+    ObjLoadStats localStats;
+    localStats.bytes = file.size();
+    localStats.threads = threadCount;
+
+    // one job per chunk, the same workers for every window
+    MyThreadPool workers(threadCount);
+    auto runChunks = [&workers](std::vector<ObjChunk>& chunks, auto&& job) {
+        for (auto& chunk : chunks) {
+            workers.submit([&chunk, &job] {
+                try {
+                    job(chunk);
+                } catch (...) {
+                    chunk.error = std::current_exception();
+                }
+            });
+        }
+        workers.wait();
+        for (auto& chunk : chunks) {
+            if (chunk.error)
+                std::rethrow_exception(chunk.error);
+        }
+    };
+
+    const char* windowBegin = fileBegin;
+    while (windowBegin < fileEnd) {
+        auto parseStart = std::chrono::high_resolution_clock::now();
+
+        const char* windowEnd = alignToLine(
+                windowBegin + std::min(windowBytes, static_cast<size_t>(fileEnd - windowBegin)),
+                windowBegin, fileEnd);
+
+        std::vector<ObjChunk> chunks;
+        const size_t chunkBytes = (windowEnd - windowBegin + threadCount - 1) / threadCount;
+        const char* chunkBegin = windowBegin;
+        while (chunkBegin < windowEnd) {
+            const char* chunkEnd = alignToLine(
+                    chunkBegin + std::min(chunkBytes, static_cast<size_t>(windowEnd - chunkBegin)),
+                    chunkBegin, windowEnd);
+            ObjChunk chunk;
+            chunk.begin = chunkBegin;
+            chunk.end = chunkEnd;
+            chunks.push_back(std::move(chunk));
+            chunkBegin = chunkEnd;
+        }
+
+        runChunks(chunks, parseChunk);
+
+        auto mergeStart = std::chrono::high_resolution_clock::now();
+
+        // append attributes in file order, remembering where each chunk starts
+        std::vector<size_t> positionBases(chunks.size());
+        std::vector<size_t> texCoordBases(chunks.size());
+        for (size_t i = 0; i < chunks.size(); i++) {
+            positionBases[i] = positions.size() / 3;
+            texCoordBases[i] = texCoords.size() / 2;
+            positions.insert(positions.end(),
+                    chunks[i].positions.begin(), chunks[i].positions.end());
+            texCoords.insert(texCoords.end(),
+                    chunks[i].texCoords.begin(), chunks[i].texCoords.end());
+            chunks[i].positions = {};
+            chunks[i].texCoords = {};
+        }
+
+        runChunks(chunks, [&](ObjChunk& chunk) {
+            size_t i = &chunk - chunks.data();
+            resolveChunk(chunk, positionBases[i], texCoordBases[i], positions, texCoords);
+        });
+
+        // dedup stays serial so the output order matches a serial parse
+        for (auto& chunk : chunks) {
+            for (const auto& vertex : chunk.vertices) {
+                indices.push_back(uniqueVertices.insert(vertex, vertices));
+            }
+        }
+
+        file.release(windowBegin - fileBegin, windowEnd - windowBegin);
+        windowBegin = windowEnd;
+
+        auto mergeEnd = std::chrono::high_resolution_clock::now();
+        localStats.parseTime += std::chrono::duration<float, std::chrono::milliseconds::period>(
+                mergeStart - parseStart).count();
+        localStats.mergeTime += std::chrono::duration<float, std::chrono::milliseconds::period>(
+                mergeEnd - mergeStart).count();
+    }
+
+    if (stats)
+        *stats = localStats;
+}
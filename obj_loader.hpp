@@ -0,0 +1,33 @@
+#pragma once
+
+//std
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+
+struct ObjLoadStats
+{
+    size_t bytes = 0;
+    unsigned threads = 0;
+    float parseTime = 0.f; // ms
+    float mergeTime = 0.f; // ms
+};
+
+/* * *
+ * Multi-threaded OBJ reader for large models. The mapped file is walked in
+ * windows, each window is split into line-aligned chunks that are parsed in
+ * parallel on one set of workers and then merged in file order, so vertices
+ * and indices come out in the order a serial parse gives them. Numbers are
+ * parsed with std::from_chars, --obj-bench compares the result against
+ * tinyobjloader. Only positions and texture coordinates are kept for the
+ * whole file; face data is dropped once its window is merged.
+ * Faces are fan triangulated, vertices deduplicated into vertices/indices.
+ */
+void loadObjParallel(const std::string& filename,
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        unsigned threadCount = 0,
+        ObjLoadStats* stats = nullptr);
@@ -1,5 +1,5 @@
 #include "pipeline.hpp"
-#include "utils.hpp"
+#include "asset_archive.hpp"
 #include "device.hpp"
 #include "vertex.hpp"
 #include "swapchain.hpp"
@@ -29,8 +29,12 @@ MyPipeline::~MyPipeline()
 
 
 
-VkShaderModule MyPipeline::createShaderModule(const std::vector<char>& code)
+VkShaderModule MyPipeline::createShaderModule(const std::string& filename)
 {
+    // mapped or archived 16 byte aligned, so the words can be read in place
+    MyAssetFile code(filename);
+    code.adviseWillNeed();
+
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     createInfo.codeSize = code.size();
@@ -49,11 +53,11 @@ void MyPipeline::createGraphicsPipeline(
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
         VkSampleCountFlagBits msaaSamples)
 {
-    auto vertShaderCode = readFile("build/shaders/shader.vert.spv");
-    auto fragShaderCode = readFile("build/shaders/shader.frag.spv");
-
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+    VkShaderModule vertShaderModule = createShaderModule("build/shaders/shader.vert.spv");
+    // the texture set layout follows the same choice, see createBindlessTextureTable
+    VkShaderModule fragShaderModule = createShaderModule(device.supportsBindlessTextures()
+            ? "build/shaders/shader_bindless.frag.spv"
+            : "build/shaders/shader.frag.spv");
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -5,6 +5,7 @@
 
 //std
 #include <vector>
+#include <string>
 
 class MyDevice;
 class MySwapChain;
@@ -32,7 +33,7 @@ public:
     VkRenderPass renderPass;
 
 private:
-    VkShaderModule createShaderModule(const std::vector<char>& code);
+    VkShaderModule createShaderModule(const std::string& filename);
     void createGraphicsPipeline(
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
         VkSampleCountFlagBits msaaSamples);
@@ -0,0 +1,105 @@
+#include "range_allocator.hpp"
+
+//std
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+float RangeAllocatorStats::fragmentation() const
+{
+    uint64_t freeSpace = capacity - used;
+    if (freeSpace == 0)
+        return 0.f;
+    return 1.f - static_cast<float>(largestFree) / freeSpace;
+}
+
+MyRangeAllocator::MyRangeAllocator(uint64_t capacity)
+    : capacity(capacity)
+{
+    if (capacity > 0)
+        insertFree(0, capacity);
+}
+
+void MyRangeAllocator::insertFree(uint64_t offset, uint64_t size)
+{
+    freeBlocks[offset] = size;
+    freeBySize.insert({size, offset});
+}
+
+void MyRangeAllocator::eraseFree(std::map<uint64_t, uint64_t>::iterator block)
+{
+    freeBySize.erase({block->second, block->first});
+    freeBlocks.erase(block);
+}
+
+uint64_t MyRangeAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0)
+        return INVALID_OFFSET;
+
+    // smallest first, only the alignment gap can make a large enough block miss
+    auto best = freeBySize.lower_bound({size, 0});
+    while (best != freeBySize.end()
+            && alignUp(best->second, alignment) + size > best->second + best->first)
+        best++;
+    if (best == freeBySize.end())
+        return INVALID_OFFSET;
+
+    uint64_t blockOffset = best->second;
+    uint64_t blockEnd = best->second + best->first;
+    uint64_t offset = alignUp(blockOffset, alignment);
+    eraseFree(freeBlocks.find(blockOffset));
+
+    // keep the alignment gap and the tail free
+    if (offset > blockOffset)
+        insertFree(blockOffset, offset - blockOffset);
+    if (offset + size < blockEnd)
+        insertFree(offset + size, blockEnd - (offset + size));
+
+    allocations[offset] = size;
+    used += size;
+    return offset;
+}
+
+void MyRangeAllocator::free(uint64_t offset)
+{
+    auto allocation = allocations.find(offset);
+    if (allocation == allocations.end())
+        throw std::runtime_error("failed to free range, not allocated!");
+    uint64_t size = allocation->second;
+    allocations.erase(allocation);
+    used -= size;
+
+    auto next = freeBlocks.lower_bound(offset);
+    if (next != freeBlocks.end() && next->first == offset + size) {
+        size += next->second;
+        eraseFree(next);
+    }
+    next = freeBlocks.lower_bound(offset);
+    if (next != freeBlocks.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            eraseFree(previous);
+        }
+    }
+    insertFree(offset, size);
+}
+
+RangeAllocatorStats MyRangeAllocator::getStats() const
+{
+    RangeAllocatorStats stats;
+    stats.capacity = capacity;
+    stats.used = used;
+    stats.freeBlocks = freeBlocks.size();
+    stats.allocations = allocations.size();
+    if (!freeBySize.empty())
+        stats.largestFree = freeBySize.rbegin()->first;
+    return stats;
+}
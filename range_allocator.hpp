@@ -0,0 +1,51 @@
+#pragma once
+
+//std
+#include <map>
+#include <set>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+struct RangeAllocatorStats
+{
+    uint64_t capacity = 0;
+    uint64_t used = 0;
+    uint64_t largestFree = 0;
+    size_t freeBlocks = 0;
+    size_t allocations = 0;
+
+    // share of the free space that is not in the largest free block
+    float fragmentation() const;
+};
+
+/* * *
+ * Best fit allocator over an abstract range [0, capacity). It only hands
+ * out offsets, the caller owns whatever the range stands for. Freed ranges
+ * are merged with free neighbours so the space can be reused. Free blocks
+ * are also indexed by size, so the search starts at the smallest one that
+ * may fit instead of walking all of them.
+ */
+class MyRangeAllocator
+{
+public:
+    static const uint64_t INVALID_OFFSET = ~0ull;
+
+    MyRangeAllocator(uint64_t capacity);
+
+    // INVALID_OFFSET when no free block is large enough
+    uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+    void free(uint64_t offset);
+
+    RangeAllocatorStats getStats() const;
+
+private:
+    uint64_t capacity;
+    uint64_t used = 0;
+    void insertFree(uint64_t offset, uint64_t size);
+    void eraseFree(std::map<uint64_t, uint64_t>::iterator block);
+
+    std::map<uint64_t, uint64_t> freeBlocks;  // offset -> size
+    std::set<std::pair<uint64_t, uint64_t>> freeBySize; // size, offset
+    std::map<uint64_t, uint64_t> allocations; // offset -> size
+};
@@ -0,0 +1,94 @@
+#include "sampler_cache.hpp"
+#include "device.hpp"
+
+//std
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+
+MySamplerCache::MySamplerCache(MyDevice& device)
+    : device(device)
+{ }
+
+MySamplerCache::~MySamplerCache()
+{
+    for (auto& [key, entry] : entries)
+        vkDestroySampler(device.device, entry.sampler, nullptr);
+    if (stats.references > 0)
+        std::cerr << "sampler cache destroyed with " << stats.references << " samplers in use\n";
+}
+
+static uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+MySamplerCache::SamplerKey MySamplerCache::makeKey(const VkSamplerCreateInfo& samplerInfo)
+{
+    return {
+        static_cast<uint32_t>(samplerInfo.flags),
+        static_cast<uint32_t>(samplerInfo.magFilter),
+        static_cast<uint32_t>(samplerInfo.minFilter),
+        static_cast<uint32_t>(samplerInfo.mipmapMode),
+        static_cast<uint32_t>(samplerInfo.addressModeU),
+        static_cast<uint32_t>(samplerInfo.addressModeV),
+        static_cast<uint32_t>(samplerInfo.addressModeW),
+        floatBits(samplerInfo.mipLodBias),
+        static_cast<uint32_t>(samplerInfo.anisotropyEnable),
+        floatBits(samplerInfo.maxAnisotropy),
+        static_cast<uint32_t>(samplerInfo.compareEnable),
+        static_cast<uint32_t>(samplerInfo.compareOp),
+        floatBits(samplerInfo.minLod),
+        floatBits(samplerInfo.maxLod),
+        static_cast<uint32_t>(samplerInfo.borderColor),
+        static_cast<uint32_t>(samplerInfo.unnormalizedCoordinates),
+    };
+}
+
+VkSampler MySamplerCache::acquire(const VkSamplerCreateInfo& samplerInfo)
+{
+    if (samplerInfo.pNext != nullptr) {
+        throw std::runtime_error("sampler cache does not support pNext chains!");
+    }
+    SamplerKey key = makeKey(samplerInfo);
+    Entry& entry = entries[key];
+    if (entry.sampler == VK_NULL_HANDLE) {
+        if (vkCreateSampler(device.device, &samplerInfo, nullptr, &entry.sampler) != VK_SUCCESS) {
+            entries.erase(key);
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+        keys[entry.sampler] = key;
+        stats.created++;
+    }
+    else
+        stats.hits++;
+    entry.references++;
+    stats.references++;
+    return entry.sampler;
+}
+
+void MySamplerCache::release(VkSampler sampler)
+{
+    auto key = keys.find(sampler);
+    // called from destructors, report instead of throwing
+    if (key == keys.end()) {
+        std::cerr << "released sampler not from the sampler cache\n";
+        return;
+    }
+    auto entry = entries.find(key->second);
+    stats.references--;
+    if (--entry->second.references > 0)
+        return;
+    vkDestroySampler(device.device, sampler, nullptr);
+    entries.erase(entry);
+    keys.erase(key);
+}
+
+SamplerCacheStats MySamplerCache::getStats() const
+{
+    SamplerCacheStats current = stats;
+    current.samplers = entries.size();
+    return current;
+}
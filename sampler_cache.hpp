@@ -0,0 +1,58 @@
+#pragma once
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+class MyDevice;
+
+struct SamplerCacheStats
+{
+    size_t samplers = 0;   // unique VkSamplers alive
+    size_t references = 0; // acquired and not released, one per texture
+    uint64_t created = 0;
+    uint64_t hits = 0;     // acquires served by an existing sampler
+};
+
+/* * *
+ * One VkSampler per distinct sampler state. acquire hands out the sampler
+ * matching every field of the create info, creating it on first use, and
+ * release destroys it once its last user is gone. pNext chains are not
+ * part of the key and must be null. Main thread only.
+ */
+class MySamplerCache
+{
+public:
+    MySamplerCache(MyDevice& device);
+    ~MySamplerCache();
+
+    MySamplerCache(const MySamplerCache& other) = delete;
+    MySamplerCache& operator=(const MySamplerCache& other) = delete;
+
+    VkSampler acquire(const VkSamplerCreateInfo& samplerInfo);
+    void release(VkSampler sampler);
+
+    SamplerCacheStats getStats() const;
+
+private:
+    // every field of VkSamplerCreateInfo after pNext, floats by their bits
+    using SamplerKey = std::array<uint32_t, 16>;
+
+    struct Entry
+    {
+        VkSampler sampler = VK_NULL_HANDLE;
+        size_t references = 0;
+    };
+
+    static SamplerKey makeKey(const VkSamplerCreateInfo& samplerInfo);
+
+    MyDevice& device;
+    std::map<SamplerKey, Entry> entries;
+    std::unordered_map<VkSampler, SamplerKey> keys;
+    SamplerCacheStats stats;
+};
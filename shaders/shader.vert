@@ -12,13 +12,19 @@ layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0)  out vec3 fragColor;
 layout(location = 1)  out vec2 fragTexCoord;
+layout(location = 2)  flat out uint fragTextureLayer;
+layout(location = 3)  flat out uint fragTextureIndex;
 
 layout(push_constant) uniform Push {
     mat4 model;
+    uint textureLayer;
+    uint textureIndex;
 } push;
 
 void main() {
     gl_Position = ubo.proj * ubo.view * push.model * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+    fragTextureLayer = push.textureLayer;
+    fragTextureIndex = push.textureIndex;
 }
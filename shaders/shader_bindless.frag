@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+// every texture, see MyDescriptorManager::createBindlessTextureTable
+layout(set = 1, binding = 0) uniform sampler2DArray textures[];
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureLayer;
+layout(location = 3) flat in uint fragTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textures[nonuniformEXT(fragTextureIndex)],
+            vec3(fragTexCoord, fragTextureLayer));
+}
@@ -4,6 +4,8 @@
 #include "game_object.hpp"
 #include "model.hpp"
 #include "texture.hpp"
+#include "camera.hpp"
+#include "geometry_store.hpp"
 
 #include <vulkan/vulkan.h>
 #define GLM_FORCE_RADIANS
@@ -12,11 +14,25 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <vector>
+#include <algorithm>
+
+// about one pixel at 1080p
+static const float MAX_SCREEN_ERROR = 1.f / 1000.f;
+
+// matches Push in shader.vert
+struct PushConstants
+{
+    glm::mat4 model;
+    uint32_t textureLayer;
+    uint32_t textureIndex; // slot in the bindless table, unused otherwise
+};
 
 SimpleRenderSystem::SimpleRenderSystem(MyDevice& device, 
+        const MyGeometryStore& geometry,
         VkRenderPass renderPass,
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
-    : device(device)
+    : device(device),
+      geometry(geometry)
 {
     createNewPipeline(renderPass, descriptorSetLayouts);
 }
@@ -26,17 +42,94 @@ SimpleRenderSystem::~SimpleRenderSystem()
 
 void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, 
         std::vector<MyGameObject>& gameObjects,
-        const std::vector<VkDescriptorSet>& globalDescriptorSets) const
+        const std::vector<VkDescriptorSet>& globalDescriptorSets,
+        const MyCamera& camera)
 {
+    cullStats = MeshletCullStats{};
+    drawStats = DrawStats{};
+    glm::mat4 viewProjection = camera.getProjection() * camera.getView();
     pipeline->bind(commandBuffer);
     pipeline->bindDescriptorSets(commandBuffer, globalDescriptorSets);
-    for (auto& gameObject : gameObjects) {
+    // every model lives in the one store, bind it once for all of them
+    geometry.bind(commandBuffer);
+
+    // objects sharing a texture set, packed arrays included, draw back to back.
+    // With the bindless table there is one set, bound once for the frame
+    drawOrder.resize(gameObjects.size());
+    for (size_t i = 0; i < gameObjects.size(); i++)
+        drawOrder[i] = &gameObjects[i];
+    std::stable_sort(drawOrder.begin(), drawOrder.end(),
+            [](const MyGameObject* a, const MyGameObject* b) {
+                return a->texture->getDescriptor() < b->texture->getDescriptor();
+            });
+
+    VkDescriptorSet boundTexture = VK_NULL_HANDLE;
+    for (MyGameObject* object : drawOrder) {
+        MyGameObject& gameObject = *object;
         glm::mat4 objMat = gameObject.transform.getMatrix();
-        pipeline->pushConstants(commandBuffer, sizeof(objMat), &objMat);
-        pipeline->bindDescriptorSets(commandBuffer, {gameObject.texture->getDescriptor()}, 1);
-        gameObject.model->bind(commandBuffer);
-        gameObject.model->draw(commandBuffer);
+        PushConstants push{objMat, gameObject.textureLayer,
+            gameObject.texture->getDescriptorIndex()};
+        pipeline->pushConstants(commandBuffer, sizeof(push), &push);
+        VkDescriptorSet textureDescriptor = gameObject.texture->getDescriptor();
+        if (textureDescriptor != boundTexture) {
+            pipeline->bindDescriptorSets(commandBuffer, {textureDescriptor}, 1);
+            boundTexture = textureDescriptor;
+            drawStats.textureBinds++;
+        }
+        drawStats.objects++;
+
+        // full detail goes through meshlet culling, coarser levels are small enough as is
+        const MyModel& model = *gameObject.model;
+        uint32_t lod = selectLod(model, objMat, camera);
+        if (lod > 0 || model.getMeshlets().empty()) {
+            model.draw(commandBuffer, lod);
+            continue;
+        }
+
+        Frustum frustum = extractFrustum(viewProjection * objMat);
+        glm::vec3 cameraPosition = glm::vec3(glm::inverse(objMat) * glm::vec4(camera.getLocation(), 1.f));
+        visibleMeshlets.clear();
+        cullMeshlets(model.getMeshlets(), frustum, cameraPosition, visibleMeshlets, &cullStats);
+        model.drawMeshlets(commandBuffer, visibleMeshlets);
+    }
+}
+
+const MeshletCullStats& SimpleRenderSystem::getCullStats() const
+{
+    return cullStats;
+}
+
+const DrawStats& SimpleRenderSystem::getDrawStats() const
+{
+    return drawStats;
+}
+
+uint32_t SimpleRenderSystem::selectLod(const MyModel& model,
+        const glm::mat4& objMat,
+        const MyCamera& camera)
+{
+    MeshBounds bounds = model.getBounds();
+    float scale = std::max({
+            glm::length(glm::vec3(objMat[0])),
+            glm::length(glm::vec3(objMat[1])),
+            glm::length(glm::vec3(objMat[2]))});
+    glm::vec3 center = glm::vec3(objMat * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.f));
+    float radius = glm::length(bounds.max - bounds.min) * 0.5f * scale;
+
+    // distance to the bounding sphere, inside it everything is full detail
+    float distance = glm::length(center - camera.getLocation()) - radius;
+    if (distance <= 0.f)
+        return 0;
+
+    // a length l at distance d covers l * proj[1][1] / (2 d) of the screen height
+    float projection = camera.getProjection()[1][1] * scale / (2.f * distance);
+    uint32_t lod = 0;
+    for (uint32_t i = 1; i < model.getLodCount(); i++) {
+        if (model.getLod(i).error * projection > MAX_SCREEN_ERROR)
+            break;
+        lod = i;
     }
+    return lod;
 }
 
 void SimpleRenderSystem::createNewPipeline(VkRenderPass newRenderPass,
@@ -1,6 +1,11 @@
 #pragma once
 
+#include "meshlet.hpp"
+
 #include <vulkan/vulkan.h>
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
 
 #include <vector>
 #include <memory>
@@ -8,11 +13,21 @@
 class MyPipeline;
 class MyGameObject;
 class MyDevice;
+class MyGeometryStore;
+class MyCamera;
+class MyModel;
+
+struct DrawStats
+{
+    size_t objects = 0;
+    size_t textureBinds = 0; // one per object before draws were grouped by texture set
+};
 
 class SimpleRenderSystem
 {
 public:
     SimpleRenderSystem(MyDevice& device, 
+            const MyGeometryStore& geometry,
             VkRenderPass renderPass,
             std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
     ~SimpleRenderSystem();
@@ -24,10 +39,25 @@ public:
             std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
     void renderGameObjects(VkCommandBuffer commandBuffer, 
             std::vector<MyGameObject>& gameObjects,
-            const std::vector<VkDescriptorSet>& globalDescriptorSet) const;
+            const std::vector<VkDescriptorSet>& globalDescriptorSet,
+            const MyCamera& camera);
+
+    // meshlet culling of the last renderGameObjects call
+    const MeshletCullStats& getCullStats() const;
+    // objects and texture set binds of the last renderGameObjects call
+    const DrawStats& getDrawStats() const;
 
 private:
+    // coarsest LOD whose error covers less than maxScreenError of the screen height
+    static uint32_t selectLod(const MyModel& model,
+            const glm::mat4& objMat,
+            const MyCamera& camera);
 
     MyDevice& device;
+    const MyGeometryStore& geometry;
     std::unique_ptr<MyPipeline> pipeline;
+    MeshletCullStats cullStats;
+    DrawStats drawStats;
+    std::vector<MyGameObject*> drawOrder;
+    std::vector<uint32_t> visibleMeshlets;
 };
@@ -50,11 +50,9 @@ void MySwapChain::init(
 MySwapChain::~MySwapChain()
 { 
     vkDestroyImageView(device.device, colorImageView, nullptr);
-    vkDestroyImage(device.device, colorImage, nullptr);
-    vkFreeMemory(device.device, colorImageMemory, nullptr);
+    device.destroyImage(colorImage, colorImageMemory);
     vkDestroyImageView(device.device, depthImageView, nullptr);
-    vkDestroyImage(device.device, depthImage, nullptr);
-    vkFreeMemory(device.device, depthImageMemory, nullptr);
+    device.destroyImage(depthImage, depthImageMemory);
 
     vkDestroyRenderPass(device.device, renderPass, nullptr);
 
@@ -113,7 +111,7 @@ void MySwapChain::createSwapChain(const VkExtent2D& windowExtent,
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-    QueueFamilyIndices indices = device.findQueueFamilies(device.physicalDevice);
+    const QueueFamilyIndices& indices = device.getQueueFamilies();
     uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), 
         indices.presentFamily.value()};
     if (indices.graphicsFamily != indices.presentFamily) {
@@ -260,7 +258,8 @@ void MySwapChain::createDepthResources()
             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             depthImage,
-            depthImageMemory);
+            depthImageMemory,
+            MemoryCategory::Attachments);
     depthImageView = device.createImageView(
             depthImage, 
             depthFormat, 
@@ -288,7 +287,8 @@ void MySwapChain::createColorResources()
                 | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             colorImage,
-            colorImageMemory);
+            colorImageMemory,
+            MemoryCategory::Attachments);
     colorImageView = device.createImageView(
             colorImage,
             colorFormat,
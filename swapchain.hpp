@@ -1,5 +1,7 @@
 #pragma once
 
+#include "memory_allocator.hpp"
+
 //libs
 #include <vulkan/vulkan.h>
 
@@ -65,10 +67,10 @@ private:
     size_t currentFrame = 0;
 
     VkImage colorImage;
-    VkDeviceMemory colorImageMemory;
+    MemoryAllocation colorImageMemory;
     VkImageView colorImageView;
 
     VkImage depthImage;
-    VkDeviceMemory depthImageMemory;
+    MemoryAllocation depthImageMemory;
     VkImageView depthImageView;
 };
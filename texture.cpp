@@ -1,5 +1,13 @@
 #include "texture.hpp"
 #include "device.hpp"
+#include "upload_scheduler.hpp"
+#include "ktx2.hpp"
+#include "mip_builder.hpp"
+#include "sampler_cache.hpp"
+#include "thread_pool.hpp"
+#include "asset_archive.hpp"
+#include "asset_manifest.hpp"
+#include "descriptor_manager.hpp"
 
 //libs
 #define STB_IMAGE_IMPLEMENTATION
@@ -7,82 +15,380 @@
 
 //std
 #include <stdexcept>
+#include <string>
+#include <utility>
 
 MyTexture::MyTexture(MyDevice& device, const char* texturePath)
+    :MyTexture(device, decode(texturePath,
+                device.getCapabilities().features.textureCompressionBC == VK_TRUE))
+{ }
+
+MyTexture::MyTexture(MyDevice& device, const TextureImage& image)
     :device(device)
 {
-    createTextureImage(texturePath);
-    createTextureImageView();
-    createTextureSampler();
+    createTextureImage(image);
 }
 
+MyTexture::MyTexture(MyDevice& device)
+    :device(device)
+{ }
+
 MyTexture::~MyTexture()
 {
-    vkDestroySampler(device.device, textureSampler, nullptr);
+    if (descriptorOwner)
+        descriptorOwner->freeTextureBinding({descriptor, descriptorIndex});
+    vkDestroyQueryPool(device.device, mipQueryPool, nullptr);
+    if (textureSampler != VK_NULL_HANDLE)
+        device.getSamplerCache().release(textureSampler);
     vkDestroyImageView(device.device, textureImageView, nullptr);
-    vkDestroyImage(device.device, textureImage, nullptr);
-    vkFreeMemory(device.device, textureImageMemory, nullptr);
+    device.destroyImage(textureImage, textureImageMemory);
 }
 
-void MyTexture::createTextureImage(const char* texturePath)
+static bool endsWith(const std::string& value, const std::string& suffix)
 {
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(texturePath, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-    mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+    return value.size() >= suffix.size()
+        && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
 
+std::string MyTexture::findKtx2(const char* texturePath, bool allowCompressed)
+{
+    std::string path = texturePath;
+    if (endsWith(path, ".ktx2"))
+        return path;
+    if (!allowCompressed)
+        return "";
+
+    // cooked textures are block compressed
+    if (const ManifestEntry* cooked = findCookedAsset(path))
+        return cooked->cooked;
+
+    // prefer the version baked by texture_encoder next to the source image
+    std::string baked = path.substr(0, path.find_last_of('.')) + ".ktx2";
+    if (MyAssetFile::exists(baked))
+        return baked;
+    return "";
+}
+
+TextureImage MyTexture::decode(const char* texturePath, bool allowCompressed)
+{
+    std::string ktx2 = findKtx2(texturePath, allowCompressed);
+    if (!ktx2.empty())
+        return loadKtx2(ktx2.c_str());
+
+    // stb decodes from the mapping instead of reading the file into its own buffer
+    MyAssetFile file(texturePath);
+    file.adviseWillNeed();
+    int texWidth, texHeight, texChannels;
+    stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()),
+            static_cast<int>(file.size()), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
     if  (!pixels) {
         throw std::runtime_error("failed to load texture image!");
     }
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    device.createBuffer(imageSize, 
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer, 
-            stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device.device, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(device.device, stagingBufferMemory);
+    TextureImage image;
+    image.width = static_cast<uint32_t>(texWidth);
+    image.height = static_cast<uint32_t>(texHeight);
+    image.pixels.assign(pixels, pixels + static_cast<size_t>(texWidth) * texHeight * 4);
     stbi_image_free(pixels);
+    return image;
+}
+
+VkDeviceSize MyTexture::getUploadSize(const TextureImage& image)
+{
+    return static_cast<VkDeviceSize>(image.pixels.size());
+}
+
+VkDeviceSize MyTexture::getRgba8Size(uint32_t width, uint32_t height)
+{
+    VkDeviceSize size = 0;
+    while (true) {
+        size += static_cast<VkDeviceSize>(width) * height * 4;
+        if (width == 1 && height == 1)
+            return size;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+}
+
+MipGeneration MyTexture::chooseMipGeneration(MyDevice& device, VkFormat format)
+{
+    VkFormatProperties formatProperties = device.getCapabilities().getFormatProperties(format);
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        return MipGeneration::Cpu;
+
+    const VkPhysicalDeviceProperties& properties = device.getProperties();
+    if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU)
+        return MipGeneration::Cpu;
+    return MipGeneration::Blit;
+}
+
+std::vector<std::shared_ptr<MyTexture>> MyTexture::createBatch(MyDevice& device,
+        const std::vector<std::string>& texturePaths,
+        unsigned threadCount)
+{
+    bool cpuMips = chooseMipGeneration(device) == MipGeneration::Cpu;
+    bool compressed = device.getCapabilities().features.textureCompressionBC == VK_TRUE;
+    std::vector<TextureImage> images(texturePaths.size());
+    std::vector<std::string> errors(texturePaths.size());
+    {
+        MyThreadPool workers(threadCount);
+        for (size_t i = 0; i < texturePaths.size(); i++) {
+            workers.submit([&, i] {
+                try {
+                    images[i] = decode(texturePaths[i].c_str(), compressed);
+                    // the pool is busy with other images, build on this thread
+                    if (cpuMips && images[i].levels.empty())
+                        buildMipChain(images[i], MipFilter::Kaiser, 1);
+                } catch (const std::exception& e) {
+                    errors[i] = e.what();
+                }
+            });
+        }
+        workers.wait();
+    }
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (!errors[i].empty()) {
+            throw std::runtime_error(texturePaths[i] + ": " + errors[i]);
+        }
+    }
+
+    MyUploadScheduler& uploads = device.getUploadScheduler();
+    std::vector<std::shared_ptr<MyTexture>> textures;
+    textures.reserve(images.size());
+    for (const auto& image : images) {
+        auto texture = std::make_shared<MyTexture>(device);
+        texture->recordUpload(image, uploads);
+        textures.push_back(std::move(texture));
+    }
+    // one batch unless the staging ring filled up and submitted early
+    uploads.waitIdle();
+    return textures;
+}
 
+void MyTexture::createTextureImage(const TextureImage& image)
+{
+    MyUploadScheduler& uploads = device.getUploadScheduler();
+    recordUpload(image, uploads);
+    uploads.wait(uploads.flush());
+}
+
+void MyTexture::recordUpload(const TextureImage& image, MyUploadScheduler& uploads, uint32_t baseLevel)
+{
+    bool precomputed = !image.levels.empty();
+    if (!precomputed && (baseLevel > 0
+                || chooseMipGeneration(device, image.format) == MipGeneration::Cpu))
+    {
+        TextureImage withMips = image;
+        buildMipChain(withMips);
+        recordUpload(withMips, uploads, baseLevel);
+        return;
+    }
+    if (precomputed && baseLevel >= image.levels.size()) {
+        throw std::runtime_error("texture base level out of range!");
+    }
+    format = image.format;
+    mipTime = image.mipTime;
+    this->baseLevel = baseLevel;
+
+    VkFormatProperties formatProperties = device.getCapabilities().getFormatProperties(format);
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        throw std::runtime_error("texture image format not supported by the device!");
+    }
+
+    // everything that can throw comes before recording, the batch may
+    // already hold other uploads
+    width = image.width;
+    height = image.height;
+    if (precomputed) {
+        mipLevels = static_cast<uint32_t>(image.levels.size()) - baseLevel;
+        width = image.levels[baseLevel].width;
+        height = image.levels[baseLevel].height;
+    }
+    else
+        mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(image.width, image.height)))) + 1;
+    // transfer source for the blits and for packing into arrays
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+        | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
     device.createImage(
-            texWidth,
-            texHeight,
+            width,
+            height,
             mipLevels,
             VK_SAMPLE_COUNT_1_BIT,
-            VK_FORMAT_R8G8B8A8_SRGB,
+            format,
             VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_TRANSFER_DST_BIT 
-                | VK_IMAGE_USAGE_SAMPLED_BIT  
-                | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            usage,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            textureImage, textureImageMemory);
-
-    device.transitionImageLayout(textureImage, 
-            VK_FORMAT_R8G8B8A8_SRGB,
+            textureImage, textureImageMemory, MemoryCategory::Textures);
+    memorySize = textureImageMemory.size;
+    createTextureImageView();
+    createTextureSampler();
+    if (!precomputed)
+        createMipQueryPool();
+
+    // block offsets have to stay block aligned in the staging buffer, levels
+    // above baseLevel are left out
+    VkDeviceSize alignment = std::max<VkDeviceSize>(getBlockSize(format), 16);
+    VkDeviceSize skipped = precomputed ? image.levels[baseLevel].offset : 0;
+    StagingRange staging = uploads.stage(getUploadSize(image) - skipped, alignment);
+    memcpy(staging.data, image.pixels.data() + skipped, image.pixels.size() - skipped);
+
+    VkCommandBuffer transferCommands = uploads.getTransferCommands();
+    device.recordTransitionImageLayout(transferCommands,
+            textureImage, 
+            format,
             VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             mipLevels);
-    device.copyBufferToImage(stagingBuffer, textureImage, 
-            static_cast<uint32_t>(texWidth),
-            static_cast<uint32_t>(texHeight));
-    generateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels);
+    if (!precomputed) {
+        device.recordCopyBufferToImage(transferCommands,
+                staging.buffer, textureImage, 
+                image.width,
+                image.height,
+                staging.offset);
+        VkCommandBuffer graphicsCommands = uploads.getGraphicsCommands();
+        // the blits run on the graphics queue, level 0 stays in transfer dst
+        device.recordImageOwnershipTransfer(transferCommands, graphicsCommands, textureImage,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT);
+        if (mipQueryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(graphicsCommands, mipQueryPool, 0, 2);
+            vkCmdWriteTimestamp(graphicsCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mipQueryPool, 0);
+        }
+        recordMipmaps(graphicsCommands, textureImage,
+                static_cast<int32_t>(image.width), static_cast<int32_t>(image.height), mipLevels);
+        if (mipQueryPool != VK_NULL_HANDLE)
+            vkCmdWriteTimestamp(graphicsCommands, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mipQueryPool, 1);
+        return;
+    }
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        const TextureLevel& level = image.levels[baseLevel + i];
+        device.recordCopyBufferToImage(transferCommands,
+                staging.buffer, textureImage,
+                level.width,
+                level.height,
+                staging.offset + level.offset - skipped,
+                i);
+    }
+    device.recordImageOwnershipTransfer(transferCommands, uploads.getGraphicsCommands(), textureImage,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void MyTexture::recordPack(const std::vector<const MyTexture*>& layers, VkCommandBuffer commandBuffer)
+{
+    const MyTexture& first = *layers.front();
+    for (const MyTexture* layer : layers) {
+        if (layer->format != first.format || layer->width != first.width
+                || layer->height != first.height || layer->mipLevels != first.mipLevels
+                || layer->layerCount != 1)
+        {
+            throw std::runtime_error("packed textures do not match!");
+        }
+    }
+    format = first.format;
+    width = first.width;
+    height = first.height;
+    mipLevels = first.mipLevels;
+    layerCount = static_cast<uint32_t>(layers.size());
+
+    device.createImage(
+            width,
+            height,
+            mipLevels,
+            VK_SAMPLE_COUNT_1_BIT,
+            format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            textureImage, textureImageMemory, MemoryCategory::Textures,
+            layerCount);
+    memorySize = textureImageMemory.size;
+    createTextureImageView();
+    createTextureSampler();
 
-    vkDestroyBuffer(device.device, stagingBuffer, nullptr);
-    vkFreeMemory(device.device, stagingBufferMemory, nullptr);
+    auto makeBarrier = [&](VkImage image, uint32_t layerCount,
+            VkImageLayout oldLayout, VkImageLayout newLayout,
+            VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcAccessMask = srcAccessMask;
+        barrier.dstAccessMask = dstAccessMask;
+        return barrier;
+    };
+
+    // the sources may still be sampled by earlier frames on this queue
+    std::vector<VkImageMemoryBarrier> barriers;
+    for (const MyTexture* layer : layers) {
+        barriers.push_back(makeBarrier(layer->textureImage, 1,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    0, VK_ACCESS_TRANSFER_READ_BIT));
+    }
+    barriers.push_back(makeBarrier(textureImage, layerCount,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                0, VK_ACCESS_TRANSFER_WRITE_BIT));
+    vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    std::vector<VkImageCopy> regions(mipLevels);
+    for (uint32_t i = 0; i < layerCount; i++) {
+        for (uint32_t level = 0; level < mipLevels; level++) {
+            VkImageCopy& region = regions[level];
+            region = VkImageCopy{};
+            region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.srcSubresource.mipLevel = level;
+            region.srcSubresource.baseArrayLayer = 0;
+            region.srcSubresource.layerCount = 1;
+            region.dstSubresource = region.srcSubresource;
+            region.dstSubresource.baseArrayLayer = i;
+            region.extent = {std::max(width >> level, 1u), std::max(height >> level, 1u), 1};
+        }
+        vkCmdCopyImage(commandBuffer,
+                layers[i]->textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                static_cast<uint32_t>(regions.size()), regions.data());
+    }
+
+    barriers.clear();
+    for (const MyTexture* layer : layers) {
+        barriers.push_back(makeBarrier(layer->textureImage, 1,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    0, VK_ACCESS_SHADER_READ_BIT));
+    }
+    barriers.push_back(makeBarrier(textureImage, layerCount,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+    vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data());
 }
 
 void MyTexture::createTextureImageView()
 {
     textureImageView = device.createImageView(
             textureImage, 
-            VK_FORMAT_R8G8B8A8_SRGB, 
+            format, 
             VK_IMAGE_ASPECT_COLOR_BIT, 
-            mipLevels);
+            mipLevels,
+            layerCount,
+            VK_IMAGE_VIEW_TYPE_2D_ARRAY);
 }
 
 void MyTexture::createTextureSampler()
@@ -95,43 +401,44 @@ void MyTexture::createTextureSampler()
     samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     samplerInfo.anisotropyEnable = VK_TRUE;
-
-    VkPhysicalDeviceProperties properties{};
-    vkGetPhysicalDeviceProperties(device.physicalDevice, &properties);
-    samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+    samplerInfo.maxAnisotropy = device.getProperties().limits.maxSamplerAnisotropy;
     samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     samplerInfo.mipLodBias = 0.f;
     samplerInfo.minLod = 0.f;
-    samplerInfo.maxLod = static_cast<float>(mipLevels);
+    // the view limits the levels, any mip count shares one sampler
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    textureSampler = device.getSamplerCache().acquire(samplerInfo);
+}
 
-    if (vkCreateSampler(device.device, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create texture sampler!");
+void MyTexture::createMipQueryPool()
+{
+    const VkPhysicalDeviceProperties& properties = device.getProperties();
+    if (!properties.limits.timestampComputeAndGraphics)
+        return;
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = 2;
+
+    if (vkCreateQueryPool(device.device, &poolInfo, nullptr, &mipQueryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create query pool!");
     }
 }
 
-void MyTexture::generateMipmaps(VkImage image,
-            VkFormat format,
+void MyTexture::recordMipmaps(VkCommandBuffer commandBuffer,
+            VkImage image,
             int32_t texWidth,
             int32_t texHeight,
             uint32_t mipLevels)
 {
-    VkCommandBuffer commandBuffer = device.beginSingleCommands(CommandPool::Command);
-
-    VkFormatProperties formatProperties;
-    vkGetPhysicalDeviceFormatProperties(device.physicalDevice, format, &formatProperties);
-    if (!(formatProperties.optimalTilingFeatures 
-                & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) 
-    {
-        throw std::runtime_error("texture image format does not support linear blitting!");
-    }
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
-    QueueFamilyIndices queueFamilyIndices = device.findQueueFamilies(device.physicalDevice);
-    barrier.srcQueueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
-    barrier.dstQueueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
@@ -201,8 +508,77 @@ void MyTexture::generateMipmaps(VkImage image,
             0, nullptr,
             0, nullptr,
             1, &barrier);
+}
+
+VkDeviceSize MyTexture::getMemorySize() const
+{
+    return memorySize;
+}
 
-    device.endSingleCommands(commandBuffer, CommandPool::Command, DeviceQueue::Graphics);
+VkFormat MyTexture::getFormat() const
+{
+    return format;
+}
+
+uint32_t MyTexture::getMipLevels() const
+{
+    return mipLevels;
+}
+
+uint32_t MyTexture::getLayerCount() const
+{
+    return layerCount;
+}
+
+uint32_t MyTexture::getWidth() const
+{
+    return width;
+}
+
+uint32_t MyTexture::getHeight() const
+{
+    return height;
+}
+
+uint32_t MyTexture::getBaseLevel() const
+{
+    return baseLevel;
+}
+
+void MyTexture::swapResources(MyTexture& other)
+{
+    std::swap(textureImage, other.textureImage);
+    std::swap(textureImageMemory, other.textureImageMemory);
+    std::swap(textureImageView, other.textureImageView);
+    std::swap(textureSampler, other.textureSampler);
+    std::swap(mipLevels, other.mipLevels);
+    std::swap(baseLevel, other.baseLevel);
+    std::swap(layerCount, other.layerCount);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(format, other.format);
+    std::swap(memorySize, other.memorySize);
+    std::swap(mipQueryPool, other.mipQueryPool);
+    std::swap(mipTime, other.mipTime);
+}
+
+float MyTexture::getMipTime()
+{
+    if (mipQueryPool == VK_NULL_HANDLE)
+        return mipTime;
+
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(device.device, mipQueryPool, 0, 2,
+            sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+        return 0.f;
+
+    const VkPhysicalDeviceProperties& properties = device.getProperties();
+    mipTime = static_cast<float>((timestamps[1] - timestamps[0]) * properties.limits.timestampPeriod * 1e-6);
+    // the results stay valid, no need to ask again
+    vkDestroyQueryPool(device.device, mipQueryPool, nullptr);
+    mipQueryPool = VK_NULL_HANDLE;
+    return mipTime;
 }
 
 VkDescriptorImageInfo MyTexture::getImageInfo() const
@@ -215,9 +591,13 @@ VkDescriptorImageInfo MyTexture::getImageInfo() const
     return imageInfo;
 }
 
-void MyTexture::setDescriptor(VkDescriptorSet descriptor)
+void MyTexture::setDescriptor(VkDescriptorSet descriptor,
+        uint32_t index,
+        MyDescriptorManager* owner)
 {
     this->descriptor = descriptor;
+    descriptorIndex = index;
+    descriptorOwner = owner;
 }
 
 VkDescriptorSet MyTexture::getDescriptor() const
@@ -225,3 +605,8 @@ VkDescriptorSet MyTexture::getDescriptor() const
     return descriptor;
 }
 
+uint32_t MyTexture::getDescriptorIndex() const
+{
+    return descriptorIndex;
+}
+
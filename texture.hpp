@@ -1,37 +1,142 @@
 #pragma once
 
+#include "memory_allocator.hpp"
+
 #include <vulkan/vulkan.h>
 
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
 class MyDevice;
+class MyUploadScheduler;
+class MyDescriptorManager;
+
+// one precomputed mip level, offset and size into TextureImage::pixels
+struct TextureLevel
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+};
+
+// decoded texture data. Without levels pixels hold the RGBA8 top level and
+// the mips are generated on the gpu, otherwise every level is uploaded as is.
+struct TextureImage
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+    std::vector<TextureLevel> levels;
+    std::vector<uint8_t> pixels;
+    // ms spent building levels on the cpu, 0 if they were not built here
+    float mipTime = 0.f;
+};
+
+enum class MipGeneration
+{
+    Blit,  // vkCmdBlitImage on the graphics queue
+    Cpu    // buildMipChain before the upload
+};
 
 class MyTexture
 {
 public:
+    // load and upload, blocking
     MyTexture(MyDevice& device, const char* texturePath);
+    MyTexture(MyDevice& device, const TextureImage& image);
+    // empty, filled in by recordUpload
+    MyTexture(MyDevice& device);
     ~MyTexture();
 
+    // load and upload several, blocking. Decodes (and builds cpu mips) on
+    // threadCount workers, then records every upload into the current batch
+    // and waits for it once instead of once per texture
+    static std::vector<std::shared_ptr<MyTexture>> createBatch(MyDevice& device,
+            const std::vector<std::string>& texturePaths,
+            unsigned threadCount = 0);
+
+    // cpu side only, safe on a worker thread. Loads .ktx2 files directly
+    // and prefers the cooked version, then a .ktx2 next to any other image
+    // if allowCompressed, pass the device's textureCompressionBC.
+    static TextureImage decode(const char* texturePath, bool allowCompressed);
+    // the .ktx2 decode reads for texturePath, empty if it decodes the image itself
+    static std::string findKtx2(const char* texturePath, bool allowCompressed);
+    static VkDeviceSize getUploadSize(const TextureImage& image);
+    // RGBA8 with a full mip chain, what the texture costs uncompressed
+    static VkDeviceSize getRgba8Size(uint32_t width, uint32_t height);
+    // blits need linear filtering of the format, and a cpu device gains
+    // nothing from doing them on the "gpu"
+    static MipGeneration chooseMipGeneration(MyDevice& device,
+            VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+    // create the image, stage the pixels and record the copy and the mip
+    // generation (or the copy of every precomputed level) into the current
+    // batch, usable once that batch completed. With a baseLevel the image
+    // only holds the levels from there down, builds them first if needed
+    void recordUpload(const TextureImage& image, MyUploadScheduler& uploads,
+            uint32_t baseLevel = 0);
+    // an array with a copy of each texture as one layer, in order. They all
+    // need the same format, size and levels. Recorded on the graphics queue
+    void recordPack(const std::vector<const MyTexture*>& layers, VkCommandBuffer commandBuffer);
+
     MyTexture(MyTexture& other) = delete;
     MyTexture operator=(MyTexture& other) = delete;
 
     VkDescriptorImageInfo getImageInfo() const;
-    void setDescriptor(VkDescriptorSet descriptor);
+    // size of the image allocation
+    VkDeviceSize getMemorySize() const;
+    VkFormat getFormat() const;
+    uint32_t getMipLevels() const;
+    uint32_t getLayerCount() const;
+    // of the resident top level
+    uint32_t getWidth() const;
+    uint32_t getHeight() const;
+    // finest level of the source image that is resident
+    uint32_t getBaseLevel() const;
+    // ms the mip levels took, cpu build time or the blits' gpu time once
+    // the upload completed. 0 if unknown
+    float getMipTime();
+    // exchange images, views and samplers, the descriptors stay. Lets the
+    // streamer replace the resident levels of a texture in use
+    void swapResources(MyTexture& other);
+    // index is the slot in the bindless table, 0 for a set of its own. The
+    // binding goes back to owner when the texture is destroyed
+    void setDescriptor(VkDescriptorSet descriptor,
+            uint32_t index = 0,
+            MyDescriptorManager* owner = nullptr);
     VkDescriptorSet getDescriptor() const;
+    uint32_t getDescriptorIndex() const;
 
 private:
-    void createTextureImage(const char* texturePath);
+    void createTextureImage(const TextureImage& image);
     void createTextureImageView();
     void createTextureSampler();
-    void generateMipmaps(VkImage image,
-            VkFormat format,
+    void createMipQueryPool();
+    // the image has to support linear blits, see chooseMipGeneration
+    void recordMipmaps(VkCommandBuffer commandBuffer,
+            VkImage image,
             int32_t texWidth,
             int32_t texHeight,
             uint32_t mipLevels);
 
-    VkImage textureImage;
-    VkDeviceMemory textureImageMemory;
-    VkImageView textureImageView;
-    VkSampler textureSampler;
-    uint32_t mipLevels;
+    VkImage textureImage = VK_NULL_HANDLE;
+    MemoryAllocation textureImageMemory;
+    VkImageView textureImageView = VK_NULL_HANDLE;
+    VkSampler textureSampler = VK_NULL_HANDLE;
+    uint32_t mipLevels = 0;
+    uint32_t baseLevel = 0;
+    uint32_t layerCount = 1;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+    VkDeviceSize memorySize = 0;
+    // two timestamps around the blits, if the graphics queue supports them
+    VkQueryPool mipQueryPool = VK_NULL_HANDLE;
+    float mipTime = 0.f;
     MyDevice& device;
-    VkDescriptorSet descriptor;
+    VkDescriptorSet descriptor = VK_NULL_HANDLE;
+    uint32_t descriptorIndex = 0;
+    MyDescriptorManager* descriptorOwner = nullptr;
 };
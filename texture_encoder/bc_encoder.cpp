@@ -0,0 +1,416 @@
+#include "bc_encoder.hpp"
+#include "../ktx2.hpp"
+
+//std
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstring>
+
+// mean and principal axis of the block's points, axis is 0 for flat blocks
+template<int N>
+static void fitLine(const float (&points)[16][N], float (&mean)[N], float (&axis)[N])
+{
+    for (int c = 0; c < N; c++) {
+        mean[c] = 0.f;
+        for (int i = 0; i < 16; i++)
+            mean[c] += points[i][c];
+        mean[c] /= 16.f;
+    }
+
+    float covariance[N][N] = {};
+    for (int i = 0; i < 16; i++) {
+        for (int a = 0; a < N; a++) {
+            for (int b = 0; b < N; b++)
+                covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+        }
+    }
+
+    // power iteration, converges fast enough for a 4x4 block
+    for (int c = 0; c < N; c++)
+        axis[c] = 1.f;
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[N] = {};
+        for (int a = 0; a < N; a++) {
+            for (int b = 0; b < N; b++)
+                next[a] += covariance[a][b] * axis[b];
+        }
+        float length = 0.f;
+        for (int c = 0; c < N; c++)
+            length += next[c] * next[c];
+        length = std::sqrt(length);
+        if (length < 1e-6f) {
+            for (int c = 0; c < N; c++)
+                axis[c] = 0.f;
+            return;
+        }
+        for (int c = 0; c < N; c++)
+            axis[c] = next[c] / length;
+    }
+}
+
+template<int N>
+static void lineEndpoints(const float (&points)[16][N], float (&low)[N], float (&high)[N])
+{
+    float mean[N], axis[N];
+    fitLine(points, mean, axis);
+    float minT = 0.f, maxT = 0.f;
+    for (int i = 0; i < 16; i++) {
+        float t = 0.f;
+        for (int c = 0; c < N; c++)
+            t += (points[i][c] - mean[c]) * axis[c];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    for (int c = 0; c < N; c++) {
+        low[c] = std::clamp(mean[c] + axis[c] * minT, 0.f, 255.f);
+        high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.f, 255.f);
+    }
+}
+
+static uint16_t packRgb565(const float color[3])
+{
+    uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.f / 255.f));
+    uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.f / 255.f));
+    uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.f / 255.f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void unpackRgb565(uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// indices for endpoints in four color mode, returns the squared error
+static int colorIndices(const uint8_t block[64], uint16_t color0, uint16_t color1, uint32_t& indices)
+{
+    int palette[4][3];
+    unpackRgb565(color0, palette[0]);
+    unpackRgb565(color1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+    }
+
+    int error = 0;
+    indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0;
+        int bestError = INT32_MAX;
+        for (int p = 0; p < 4; p++) {
+            int e = 0;
+            for (int c = 0; c < 3; c++) {
+                int d = block[i * 4 + c] - palette[p][c];
+                e += d * d;
+            }
+            if (e < bestError) {
+                bestError = e;
+                best = p;
+            }
+        }
+        indices |= static_cast<uint32_t>(best) << (2 * i);
+        error += bestError;
+    }
+    return error;
+}
+
+// least squares endpoints for the given indices, false if degenerate
+static bool refineColorEndpoints(const uint8_t block[64], uint32_t indices, float color0[3], float color1[3])
+{
+    static const float weights[4] = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    float ap[3] = {}, bp[3] = {};
+    for (int i = 0; i < 16; i++) {
+        float a = weights[(indices >> (2 * i)) & 3];
+        float b = 1.f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; c++) {
+            ap[c] += a * block[i * 4 + c];
+            bp[c] += b * block[i * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+    for (int c = 0; c < 3; c++) {
+        color0[c] = std::clamp((bb * ap[c] - ab * bp[c]) / det, 0.f, 255.f);
+        color1[c] = std::clamp((aa * bp[c] - ab * ap[c]) / det, 0.f, 255.f);
+    }
+    return true;
+}
+
+static void encodeColor(const uint8_t block[64], uint8_t out[8])
+{
+    float points[16][3];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++)
+            points[i][c] = block[i * 4 + c];
+    }
+    float low[3], high[3];
+    lineEndpoints(points, low, high);
+
+    uint16_t color0 = packRgb565(high);
+    uint16_t color1 = packRgb565(low);
+    uint32_t indices;
+    int error = colorIndices(block, color0, color1, indices);
+
+    float refined0[3], refined1[3];
+    if (color0 != color1 && refineColorEndpoints(block, indices, refined0, refined1)) {
+        uint16_t candidate0 = packRgb565(refined0);
+        uint16_t candidate1 = packRgb565(refined1);
+        uint32_t candidateIndices;
+        int candidateError = colorIndices(block, candidate0, candidate1, candidateIndices);
+        if (candidateError < error) {
+            color0 = candidate0;
+            color1 = candidate1;
+            indices = candidateIndices;
+        }
+    }
+
+    // four color mode needs color0 > color1
+    if (color0 < color1) {
+        std::swap(color0, color1);
+        indices ^= 0x55555555; // 0<->1, 2<->3
+    }
+    else if (color0 == color1) {
+        indices = 0;
+    }
+
+    out[0] = static_cast<uint8_t>(color0);
+    out[1] = static_cast<uint8_t>(color0 >> 8);
+    out[2] = static_cast<uint8_t>(color1);
+    out[3] = static_cast<uint8_t>(color1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+void encodeBC1(const uint8_t block[64], uint8_t out[8])
+{
+    encodeColor(block, out);
+}
+
+void encodeBC4(const uint8_t block[64], uint32_t channel, uint8_t out[8])
+{
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++) {
+        low = std::min<int>(low, block[i * 4 + channel]);
+        high = std::max<int>(high, block[i * 4 + channel]);
+    }
+
+    memset(out, 0, 8);
+    out[0] = static_cast<uint8_t>(high);
+    out[1] = static_cast<uint8_t>(low);
+    if (high == low)
+        return;
+
+    // eight value mode, endpoints first then six interpolated values
+    int palette[8];
+    palette[0] = high;
+    palette[1] = low;
+    for (int k = 2; k < 8; k++)
+        palette[k] = ((8 - k) * high + (k - 1) * low + 3) / 7;
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int value = block[i * 4 + channel];
+        int best = 0;
+        for (int k = 1; k < 8; k++) {
+            if (std::abs(value - palette[k]) < std::abs(value - palette[best]))
+                best = k;
+        }
+        indices |= static_cast<uint64_t>(best) << (3 * i);
+    }
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+void encodeBC3(const uint8_t block[64], uint8_t out[16])
+{
+    encodeBC4(block, 3, out);
+    encodeColor(block, out + 8);
+}
+
+void encodeBC5(const uint8_t block[64], uint8_t out[16])
+{
+    encodeBC4(block, 0, out);
+    encodeBC4(block, 1, out + 8);
+}
+
+struct BitWriter
+{
+    uint8_t* out;
+    uint32_t position = 0;
+
+    void write(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t i = 0; i < bits; i++, position++) {
+            if ((value >> i) & 1)
+                out[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+        }
+    }
+};
+
+// 7 bit endpoint plus shared p bit closest to color
+static void quantizeBC7Endpoint(const float color[4], uint32_t quantized[4], uint32_t& pBit)
+{
+    float bestError = 1e30f;
+    for (uint32_t p = 0; p < 2; p++) {
+        uint32_t candidate[4];
+        float error = 0.f;
+        for (int c = 0; c < 4; c++) {
+            float value = std::round((color[c] - static_cast<float>(p)) / 2.f);
+            candidate[c] = static_cast<uint32_t>(std::clamp(value, 0.f, 127.f));
+            float d = static_cast<float>((candidate[c] << 1) | p) - color[c];
+            error += d * d;
+        }
+        if (error < bestError) {
+            bestError = error;
+            pBit = p;
+            std::copy(candidate, candidate + 4, quantized);
+        }
+    }
+}
+
+void encodeBC7(const uint8_t block[64], uint8_t out[16])
+{
+    static const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    float points[16][4];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 4; c++)
+            points[i][c] = block[i * 4 + c];
+    }
+    float low[4], high[4];
+    lineEndpoints(points, low, high);
+
+    uint32_t endpoints[2][4];
+    uint32_t pBits[2];
+    quantizeBC7Endpoint(low, endpoints[0], pBits[0]);
+    quantizeBC7Endpoint(high, endpoints[1], pBits[1]);
+
+    int palette[16][4];
+    for (int k = 0; k < 16; k++) {
+        for (int c = 0; c < 4; c++) {
+            int e0 = static_cast<int>((endpoints[0][c] << 1) | pBits[0]);
+            int e1 = static_cast<int>((endpoints[1][c] << 1) | pBits[1]);
+            palette[k][c] = ((64 - weights[k]) * e0 + weights[k] * e1 + 32) >> 6;
+        }
+    }
+
+    uint32_t indices[16];
+    for (int i = 0; i < 16; i++) {
+        int bestError = INT32_MAX;
+        for (uint32_t k = 0; k < 16; k++) {
+            int error = 0;
+            for (int c = 0; c < 4; c++) {
+                int d = block[i * 4 + c] - palette[k][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                indices[i] = k;
+            }
+        }
+    }
+
+    // the anchor index is stored without its top bit, it has to be below 8
+    if (indices[0] >= 8) {
+        std::swap(endpoints[0], endpoints[1]);
+        std::swap(pBits[0], pBits[1]);
+        for (auto& index : indices)
+            index = 15 - index;
+    }
+
+    memset(out, 0, 16);
+    BitWriter writer{out};
+    writer.write(1u << 6, 7); // mode 6
+    for (int c = 0; c < 4; c++) {
+        writer.write(endpoints[0][c], 7);
+        writer.write(endpoints[1][c], 7);
+    }
+    writer.write(pBits[0], 1);
+    writer.write(pBits[1], 1);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        writer.write(indices[i], 4);
+}
+
+std::vector<uint8_t> compressLevel(const uint8_t* pixels,
+        uint32_t width,
+        uint32_t height,
+        VkFormat format)
+{
+    uint32_t blockSize = getBlockSize(format);
+    if (blockSize == 0)
+        return std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+    std::vector<uint8_t> compressed(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+    for (uint32_t by = 0; by < blocksY; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++) {
+            uint8_t block[64];
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sy = std::min(by * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sx = std::min(bx * 4 + x, width - 1);
+                    memcpy(block + (y * 4 + x) * 4,
+                            pixels + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+                }
+            }
+
+            uint8_t* out = compressed.data() + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+            switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                encodeBC1(block, out);
+                break;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+                encodeBC3(block, out);
+                break;
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+                encodeBC5(block, out);
+                break;
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                encodeBC7(block, out);
+                break;
+            default:
+                throw std::runtime_error("unsupported block format!");
+            }
+        }
+    }
+    return compressed;
+}
+
+TextureImage compressImage(const TextureImage& source, VkFormat format)
+{
+    TextureImage image;
+    image.width = source.width;
+    image.height = source.height;
+    image.format = format;
+    VkDeviceSize alignment = std::max<VkDeviceSize>(getBlockSize(format), 4);
+    for (const auto& level : source.levels) {
+        std::vector<uint8_t> encoded = compressLevel(source.pixels.data() + level.offset,
+                level.width, level.height, format);
+
+        TextureLevel entry;
+        entry.width = level.width;
+        entry.height = level.height;
+        entry.offset = (image.pixels.size() + alignment - 1) / alignment * alignment;
+        entry.size = encoded.size();
+        image.pixels.resize(static_cast<size_t>(entry.offset));
+        image.pixels.insert(image.pixels.end(), encoded.begin(), encoded.end());
+        image.levels.push_back(entry);
+    }
+    return image;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../texture.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <vector>
+#include <cstdint>
+
+/* * *
+ * Block encoders for the formats the renderer loads from KTX2. Every
+ * function takes one 4x4 block of RGBA8 pixels, row major.
+ *
+ * BC1 and the color half of BC3 fit endpoints along the principal axis of
+ * the block colors and refine them once with least squares. BC4 (the alpha
+ * half of BC3, both halves of BC5) uses the channel range. BC7 only uses
+ * mode 6, one RGBA subset with 4 bit indices, which is fast and holds up
+ * well on photographic textures.
+ */
+void encodeBC1(const uint8_t block[64], uint8_t out[8]);
+void encodeBC3(const uint8_t block[64], uint8_t out[16]);
+void encodeBC4(const uint8_t block[64], uint32_t channel, uint8_t out[8]);
+void encodeBC5(const uint8_t block[64], uint8_t out[16]);
+void encodeBC7(const uint8_t block[64], uint8_t out[16]);
+
+// compress a whole RGBA8 level, edges are padded by repeating the last
+// row and column
+std::vector<uint8_t> compressLevel(const uint8_t* pixels,
+        uint32_t width,
+        uint32_t height,
+        VkFormat format);
+// compress every level of an RGBA8 image with its mip chain built
+TextureImage compressImage(const TextureImage& source, VkFormat format);
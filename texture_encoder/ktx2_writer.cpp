@@ -0,0 +1,165 @@
+#include "ktx2_writer.hpp"
+#include "../ktx2.hpp"
+
+//std
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <cstring>
+
+// Khronos data format descriptor color models and channels
+static const uint32_t KHR_DF_MODEL_RGBSDA = 1;
+static const uint32_t KHR_DF_MODEL_BC1A = 128;
+static const uint32_t KHR_DF_MODEL_BC3 = 130;
+static const uint32_t KHR_DF_MODEL_BC5 = 132;
+static const uint32_t KHR_DF_MODEL_BC7 = 134;
+static const uint32_t KHR_DF_CHANNEL_COLOR = 0;
+static const uint32_t KHR_DF_CHANNEL_GREEN = 1;
+static const uint32_t KHR_DF_CHANNEL_BLUE = 2;
+static const uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+static const uint32_t KHR_DF_QUALIFIER_LINEAR = 1 << 4;
+static const uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+static const uint32_t KHR_DF_TRANSFER_SRGB = 2;
+static const uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+
+struct DfdSample
+{
+    uint32_t bitOffset;
+    uint32_t bitLength;
+    uint32_t channel;
+    uint32_t upper;
+};
+
+static bool isSrgb(VkFormat format)
+{
+    return format == VK_FORMAT_R8G8B8A8_SRGB
+        || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK
+        || format == VK_FORMAT_BC3_SRGB_BLOCK
+        || format == VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+static std::vector<uint32_t> buildDfd(VkFormat format)
+{
+    uint32_t model;
+    std::vector<DfdSample> samples;
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        model = KHR_DF_MODEL_BC1A;
+        samples = {{0, 64, KHR_DF_CHANNEL_COLOR, 0xFFFFFFFF}};
+        break;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        model = KHR_DF_MODEL_BC3;
+        samples = {{0, 64, KHR_DF_CHANNEL_ALPHA, 0xFFFFFFFF},
+                   {64, 64, KHR_DF_CHANNEL_COLOR, 0xFFFFFFFF}};
+        break;
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        model = KHR_DF_MODEL_BC5;
+        samples = {{0, 64, KHR_DF_CHANNEL_COLOR, 0xFFFFFFFF},
+                   {64, 64, KHR_DF_CHANNEL_GREEN, 0xFFFFFFFF}};
+        break;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        model = KHR_DF_MODEL_BC7;
+        samples = {{0, 128, KHR_DF_CHANNEL_COLOR, 0xFFFFFFFF}};
+        break;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        model = KHR_DF_MODEL_RGBSDA;
+        samples = {{0, 8, KHR_DF_CHANNEL_COLOR, 255},
+                   {8, 8, KHR_DF_CHANNEL_GREEN, 255},
+                   {16, 8, KHR_DF_CHANNEL_BLUE, 255},
+                   {24, 8, KHR_DF_CHANNEL_ALPHA, 255}};
+        break;
+    default:
+        throw std::runtime_error("unsupported ktx2 format!");
+    }
+
+    uint32_t blockSize = getBlockSize(format);
+    bool srgb = isSrgb(format);
+    uint32_t blockDimension = blockSize ? 3 : 0; // stored as size - 1
+    uint32_t descriptorSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+    std::vector<uint32_t> dfd;
+    dfd.push_back(4 + descriptorSize); // total size
+    dfd.push_back(0);                  // vendor khronos, basic descriptor
+    dfd.push_back(2 | (descriptorSize << 16));
+    dfd.push_back(model | (KHR_DF_PRIMARIES_BT709 << 8)
+            | ((srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16));
+    dfd.push_back(blockDimension | (blockDimension << 8));
+    dfd.push_back(blockSize ? blockSize : 4); // bytes in plane 0
+    dfd.push_back(0);
+    for (const auto& sample : samples) {
+        uint32_t channel = sample.channel;
+        // alpha is never sRGB encoded
+        if (srgb && channel == KHR_DF_CHANNEL_ALPHA)
+            channel |= KHR_DF_QUALIFIER_LINEAR;
+        dfd.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (channel << 24));
+        dfd.push_back(0);
+        dfd.push_back(0);
+        dfd.push_back(sample.upper);
+    }
+    return dfd;
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void writeKtx2(const char* path, const TextureImage& image)
+{
+    if (image.levels.empty() || !isSupportedKtx2Format(image.format)) {
+        throw std::runtime_error("ktx2 output needs a supported format and precomputed levels!");
+    }
+
+    uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+    std::vector<uint32_t> dfd = buildDfd(image.format);
+
+    Ktx2Header header{};
+    memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    header.vkFormat = static_cast<uint32_t>(image.format);
+    header.typeSize = 1;
+    header.pixelWidth = image.width;
+    header.pixelHeight = image.height;
+    header.pixelDepth = 0;
+    header.layerCount = 0;
+    header.faceCount = 1;
+    header.levelCount = levelCount;
+    header.supercompressionScheme = 0;
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(Ktx2Header) + sizeof(Ktx2LevelIndex) * levelCount);
+    header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+    // level data is aligned to lcm(texel block size, 4)
+    uint64_t alignment = getBlockSize(image.format) ? getBlockSize(image.format) : 4;
+    std::vector<Ktx2LevelIndex> index(levelCount);
+    uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+    for (uint32_t i = levelCount; i-- > 0;) {
+        offset = alignUp(offset, alignment);
+        index[i].byteOffset = offset;
+        index[i].byteLength = image.levels[i].size;
+        index[i].uncompressedByteLength = image.levels[i].size;
+        offset += image.levels[i].size;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open ktx2 output!");
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(index.data()), sizeof(Ktx2LevelIndex) * levelCount);
+    file.write(reinterpret_cast<const char*>(dfd.data()), header.dfdByteLength);
+
+    uint64_t written = header.dfdByteOffset + header.dfdByteLength;
+    const char padding[16] = {};
+    for (uint32_t i = levelCount; i-- > 0;) {
+        file.write(padding, static_cast<std::streamsize>(index[i].byteOffset - written));
+        file.write(reinterpret_cast<const char*>(image.pixels.data() + image.levels[i].offset),
+                static_cast<std::streamsize>(image.levels[i].size));
+        written = index[i].byteOffset + index[i].byteLength;
+    }
+    if (!file) {
+        throw std::runtime_error("failed to write ktx2 output!");
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../texture.hpp"
+
+/* * *
+ * Writes image with all of its levels as a 2D KTX2 file without
+ * supercompression, levels stored smallest first as the spec recommends.
+ */
+void writeKtx2(const char* path, const TextureImage& image);
@@ -0,0 +1,135 @@
+#include "bc_encoder.hpp"
+#include "ktx2_writer.hpp"
+#include "../ktx2.hpp"
+#include "../mip_builder.hpp"
+
+//libs
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+//std
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+/* * *
+ * Offline texture baking: loads an image, builds the full mip chain on the
+ * cpu and block compresses every level into a KTX2 file MyTexture uploads
+ * without any runtime processing.
+ *
+ *   texture_encoder <input> <output.ktx2> [bc1|bc3|bc5|bc7|rgba8] [--linear] [--box]
+ *   texture_encoder <input> --bench
+ *
+ * Color data is treated as sRGB unless --linear is given, BC5 (normal
+ * maps) is always linear. Mips use the Kaiser filter unless --box is given.
+ * --bench only times buildMipChain with every filter.
+ */
+
+// every filter single threaded and on all threads, the input is not written
+static void benchmark(const TextureImage& source)
+{
+    const std::pair<MipFilter, const char*> filters[] = {
+        {MipFilter::Box, "box"}, {MipFilter::Kaiser, "kaiser"}};
+    for (const auto& filter : filters) {
+        for (unsigned threads : {1u, 0u}) {
+            TextureImage image = source;
+            buildMipChain(image, filter.first, threads);
+            double megapixels = 0.0;
+            for (const auto& level : image.levels)
+                megapixels += static_cast<double>(level.width) * level.height / 1e6;
+            std::cout << filter.second << ", " << (threads == 1 ? "1 thread" : "all threads")
+                << ": " << image.mipTime << " ms, "
+                << megapixels / (image.mipTime / 1000.0) << " MPix/s\n";
+        }
+    }
+}
+
+static bool parseFormat(const std::string& name, bool linear, VkFormat& format)
+{
+    if (name == "bc1")
+        format = linear ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+    else if (name == "bc3")
+        format = linear ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC3_SRGB_BLOCK;
+    else if (name == "bc5")
+        format = VK_FORMAT_BC5_UNORM_BLOCK;
+    else if (name == "bc7")
+        format = linear ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+    else if (name == "rgba8")
+        format = linear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0]
+            << " <input> <output.ktx2> [bc1|bc3|bc5|bc7|rgba8] [--linear] [--box]\n"
+            << "       " << argv[0] << " <input> --bench\n";
+        return EXIT_FAILURE;
+    }
+    bool bench = strcmp(argv[2], "--bench") == 0;
+    std::string formatName = "bc7";
+    bool linear = false;
+    MipFilter filter = MipFilter::Kaiser;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--linear") == 0)
+            linear = true;
+        else if (strcmp(argv[i], "--box") == 0)
+            filter = MipFilter::Box;
+        else
+            formatName = argv[i];
+    }
+    VkFormat format;
+    if (!parseFormat(formatName, linear, format)) {
+        std::cerr << "unknown format " << formatName << "\n";
+        return EXIT_FAILURE;
+    }
+    bool srgb = !linear && format != VK_FORMAT_BC5_UNORM_BLOCK;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int texWidth, texHeight, texChannels;
+    stbi_uc* pixels = stbi_load(argv[1], &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    if (!pixels) {
+        std::cerr << "failed to load " << argv[1] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    TextureImage source;
+    source.width = static_cast<uint32_t>(texWidth);
+    source.height = static_cast<uint32_t>(texHeight);
+    source.format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    source.pixels.assign(pixels, pixels + static_cast<size_t>(texWidth) * texHeight * 4);
+    stbi_image_free(pixels);
+    if (bench) {
+        benchmark(source);
+        return EXIT_SUCCESS;
+    }
+    buildMipChain(source, filter);
+    TextureImage image = compressImage(source, format);
+
+    try {
+        writeKtx2(argv[2], image);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    float time = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - start).count();
+    VkDeviceSize encodedSize = 0;
+    VkDeviceSize rgba8Size = 0;
+    for (const auto& entry : image.levels) {
+        encodedSize += entry.size;
+        rgba8Size += static_cast<VkDeviceSize>(entry.width) * entry.height * 4;
+    }
+    std::cout << argv[1] << " -> " << argv[2] << ": " << image.width << "x" << image.height
+        << " " << formatName << ", " << image.levels.size() << " levels, "
+        << encodedSize / 1024 << " KiB (RGBA8 with mips " << rgba8Size / 1024 << " KiB, "
+        << static_cast<double>(rgba8Size) / encodedSize << "x) in " << time << " ms\n";
+    return EXIT_SUCCESS;
+}
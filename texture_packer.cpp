@@ -0,0 +1,90 @@
+#include "texture_packer.hpp"
+#include "device.hpp"
+#include "descriptor_manager.hpp"
+#include "texture.hpp"
+#include "texture_streamer.hpp"
+#include "game_object.hpp"
+
+//std
+#include <iostream>
+#include <stdexcept>
+#include <map>
+#include <unordered_map>
+#include <tuple>
+#include <algorithm>
+
+MyTexturePacker::MyTexturePacker(MyDevice& device,
+        MyDescriptorManager& descriptorManager,
+        const MyTextureStreamer* streamer)
+    : device(device),
+      descriptorManager(descriptorManager),
+      streamer(streamer)
+{ }
+
+MyTexturePacker::~MyTexturePacker()
+{ }
+
+void MyTexturePacker::pack(std::vector<MyGameObject>& gameObjects)
+{
+    // format, width, height, levels
+    using GroupKey = std::tuple<VkFormat, uint32_t, uint32_t, uint32_t>;
+    std::map<GroupKey, std::vector<const MyTexture*>> groups;
+    std::unordered_map<const MyTexture*, std::vector<MyGameObject*>> users;
+    for (auto& gameObject : gameObjects) {
+        if (!gameObject.texture.isReady())
+            continue;
+        const MyTexture* texture = gameObject.texture.get();
+        if (texture->getLayerCount() != 1 || (streamer && streamer->isStreamed(*texture)))
+            continue;
+        auto& textureUsers = users[texture];
+        if (textureUsers.empty()) {
+            GroupKey key{texture->getFormat(), texture->getWidth(), texture->getHeight(),
+                texture->getMipLevels()};
+            groups[key].push_back(texture);
+        }
+        textureUsers.push_back(&gameObject);
+    }
+    stats.textures += users.size();
+
+    size_t maxLayers = device.getProperties().limits.maxImageArrayLayers;
+    VkCommandBuffer commandBuffer = device.beginSingleCommands(CommandPool::Command);
+    for (auto& [key, textures] : groups) {
+        for (size_t first = 0; first + 1 < textures.size(); first += maxLayers) {
+            std::vector<const MyTexture*> layers(textures.begin() + first,
+                    textures.begin() + std::min(textures.size(), first + maxLayers));
+            if (layers.size() < 2)
+                break;
+
+            auto array = std::make_shared<MyTexture>(device);
+            try {
+                TextureBinding binding = descriptorManager.allocateTextureBinding();
+                array->setDescriptor(binding.descriptor, binding.index, &descriptorManager);
+                array->recordPack(layers, commandBuffer);
+            } catch (const std::runtime_error& e) {
+                // nothing of this array was recorded, its textures stay as they are
+                std::cerr << "failed to pack textures: " << e.what() << "\n";
+                continue;
+            }
+
+            descriptorManager.writeTextureBinding({array->getDescriptor(),
+                    array->getDescriptorIndex()}, *array);
+            for (uint32_t layer = 0; layer < layers.size(); layer++) {
+                for (MyGameObject* gameObject : users[layers[layer]]) {
+                    gameObject->texture = MyAssetHandle<MyTexture>(array);
+                    gameObject->textureLayer = layer;
+                }
+                stats.packedBytes += layers[layer]->getMemorySize();
+            }
+            stats.packedTextures += layers.size();
+            stats.arrays++;
+            stats.arrayBytes += array->getMemorySize();
+            arrays.push_back(std::move(array));
+        }
+    }
+    device.endSingleCommands(commandBuffer, DeviceQueue::Graphics);
+}
+
+const TexturePackerStats& MyTexturePacker::getStats() const
+{
+    return stats;
+}
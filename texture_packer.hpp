@@ -0,0 +1,68 @@
+#pragma once
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+class MyDevice;
+class MyDescriptorManager;
+class MyTexture;
+class MyTextureStreamer;
+class MyGameObject;
+
+struct TexturePackerStats
+{
+    size_t textures = 0;          // distinct resident textures looked at
+    size_t packedTextures = 0;    // now a layer of an array
+    size_t arrays = 0;
+    VkDeviceSize arrayBytes = 0;  // memory of the arrays
+    VkDeviceSize packedBytes = 0; // memory of the textures they copy
+
+    // share of the textures drawn without a descriptor switch between them
+    float packedFraction() const
+    {
+        return textures ? static_cast<float>(packedTextures) / textures : 0.f;
+    }
+    // texture memory per array memory, below 1 for alignment and padding
+    float efficiency() const
+    {
+        return arrayBytes ? static_cast<float>(packedBytes) / arrayBytes : 0.f;
+    }
+};
+
+/* * *
+ * Packs textures with the same format, size and mip count into 2D array
+ * textures, one layer each, and points the objects using them at the array
+ * and their layer. Objects sharing an array draw without rebinding the
+ * texture descriptor set. Textures only go in whole, so no uv remapping
+ * is needed and mips and wrapping keep working. Streamed textures keep
+ * changing their levels and are left out.
+ */
+class MyTexturePacker
+{
+public:
+    MyTexturePacker(MyDevice& device,
+            MyDescriptorManager& descriptorManager,
+            const MyTextureStreamer* streamer = nullptr);
+    ~MyTexturePacker();
+
+    MyTexturePacker(const MyTexturePacker& other) = delete;
+    MyTexturePacker& operator=(const MyTexturePacker& other) = delete;
+
+    // packs the resident textures of gameObjects, blocking until copied.
+    // Groups of one stay as they are
+    void pack(std::vector<MyGameObject>& gameObjects);
+
+    const TexturePackerStats& getStats() const;
+
+private:
+    MyDevice& device;
+    MyDescriptorManager& descriptorManager;
+    const MyTextureStreamer* streamer;
+    std::vector<std::shared_ptr<MyTexture>> arrays;
+    TexturePackerStats stats;
+};
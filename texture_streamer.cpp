@@ -0,0 +1,337 @@
+#include "texture_streamer.hpp"
+#include "device.hpp"
+#include "descriptor_manager.hpp"
+#include "game_object.hpp"
+#include "model.hpp"
+#include "camera.hpp"
+#include "swapchain.hpp"
+#include "ktx2.hpp"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//std
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+// larger side of the coarsest level set that always stays resident
+static const uint32_t INITIAL_SIZE = 128;
+// staged level data per frame, at least one texture goes out regardless
+static const VkDeviceSize UPLOAD_BYTES_PER_FRAME = 32 * 1024 * 1024;
+// a frame recorded in update n is done once update n + FRAME_DELAY starts
+static const uint64_t FRAME_DELAY = MySwapChain::MAX_FRAMES_IN_FLIGHT + 1;
+
+MyTextureStreamer::MyTextureStreamer(MyDevice& device,
+        MyDescriptorManager& descriptorManager,
+        VkDeviceSize budget)
+    : device(device),
+      descriptorManager(descriptorManager),
+      uploadScheduler(device.getUploadScheduler()),
+      budget(budget)
+{ }
+
+MyTextureStreamer::~MyTextureStreamer()
+{
+    // pending level uploads still write the replacement images
+    uploadScheduler.waitIdle();
+    for (const auto& streamed : textures)
+        descriptorManager.freeTextureBinding(streamed.spareBinding);
+}
+
+uint32_t MyTextureStreamer::getInitialLevel(const TextureImage& image)
+{
+    if (image.levels.empty())
+        return 0;
+    for (uint32_t i = 0; i < image.levels.size(); i++) {
+        if (std::max(image.levels[i].width, image.levels[i].height) <= INITIAL_SIZE)
+            return i;
+    }
+    return static_cast<uint32_t>(image.levels.size()) - 1;
+}
+
+void MyTextureStreamer::add(const std::shared_ptr<MyTexture>& texture,
+        const TextureImage& image,
+        const std::string& levelPath)
+{
+    if (image.levels.empty()) {
+        throw std::runtime_error("streamed texture without precomputed levels!");
+    }
+    Streamed streamed;
+    streamed.initialLevel = getInitialLevel(image);
+    // small enough to be resident as a whole
+    if (streamed.initialLevel == 0)
+        return;
+    // a texture freed since the last update may have left its address to this one
+    removeExpired();
+    streamed.wantedLevel = streamed.initialLevel;
+    streamed.lastRequested = frame;
+    streamed.spareBinding = descriptorManager.allocateTextureBinding();
+    streamed.texture = texture;
+    streamed.levelPath = levelPath;
+    streamed.layout.width = image.width;
+    streamed.layout.height = image.height;
+    streamed.layout.format = image.format;
+    streamed.layout.levels = image.levels;
+    indices[texture.get()] = textures.size();
+    textures.push_back(std::move(streamed));
+}
+
+void MyTextureStreamer::removeExpired()
+{
+    size_t kept = 0;
+    for (auto& streamed : textures) {
+        if (streamed.texture.expired()) {
+            descriptorManager.freeTextureBinding(streamed.spareBinding);
+            // a replacement still uploading goes once its batch completed
+            if (streamed.next) {
+                Retired r;
+                r.texture = std::move(streamed.next);
+                r.frame = frame;
+                r.token = streamed.token;
+                retired.push_back(std::move(r));
+            }
+            continue;
+        }
+        if (&textures[kept] != &streamed)
+            textures[kept] = std::move(streamed);
+        kept++;
+    }
+    if (kept == textures.size())
+        return;
+    textures.erase(textures.begin() + kept, textures.end());
+    indices.clear();
+    for (size_t i = 0; i < textures.size(); i++)
+        indices[textures[i].texture.lock().get()] = i;
+}
+
+bool MyTextureStreamer::isStreamed(const MyTexture& texture) const
+{
+    return indices.count(&texture) > 0;
+}
+
+void MyTextureStreamer::requestLevels(const std::vector<MyGameObject>& gameObjects,
+        const MyCamera& camera,
+        uint32_t viewportHeight)
+{
+    for (const auto& gameObject : gameObjects) {
+        auto index = indices.find(gameObject.texture.get());
+        if (index == indices.end() || !gameObject.model)
+            continue;
+        Streamed& streamed = textures[index->second];
+        // freed and its address taken by a texture that is not streamed
+        if (streamed.texture.lock().get() != gameObject.texture.get())
+            continue;
+
+        // bounding sphere on screen as in SimpleRenderSystem::selectLod
+        glm::mat4 objMat = gameObject.transform.getMatrix();
+        MeshBounds bounds = gameObject.model->getBounds();
+        float scale = std::max({
+                glm::length(glm::vec3(objMat[0])),
+                glm::length(glm::vec3(objMat[1])),
+                glm::length(glm::vec3(objMat[2]))});
+        glm::vec3 center = glm::vec3(objMat * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.f));
+        float radius = glm::length(bounds.max - bounds.min) * 0.5f * scale;
+        float distance = glm::length(center - camera.getLocation()) - radius;
+
+        // assume the texture is stretched over the object once
+        uint32_t level = 0;
+        if (distance > 0.f) {
+            float pixels = camera.getProjection()[1][1] * radius / distance * viewportHeight;
+            uint32_t size = std::max(streamed.layout.width, streamed.layout.height);
+            float ratio = static_cast<float>(size) / std::max(pixels, 1.f);
+            if (ratio > 1.f)
+                level = static_cast<uint32_t>(std::floor(std::log2(ratio)));
+        }
+        streamed.wantedLevel = std::min(streamed.wantedLevel, level);
+        streamed.lastRequested = frame + 1;
+    }
+}
+
+void MyTextureStreamer::update()
+{
+    frame++;
+    uploadedBytes = 0;
+    stats.promotions = 0;
+    stats.evictions = 0;
+
+    retired.erase(std::remove_if(retired.begin(), retired.end(),
+                [this](const Retired& r) {
+                    return r.frame <= frame && uploadScheduler.isComplete(r.token);
+                }),
+            retired.end());
+    removeExpired();
+
+    for (auto& streamed : textures) {
+        if (streamed.next && uploadScheduler.isComplete(streamed.token)
+                && streamed.spareFreeFrame <= frame)
+        {
+            swapIn(streamed);
+        }
+    }
+
+    VkDeviceSize committed = getCommittedBytes();
+    if (committed > budget)
+        committed -= evict(committed - budget);
+    promote(committed);
+
+    if (uploadedBytes > 0)
+        uploadScheduler.flush();
+
+    stats.budget = budget;
+    stats.textures = textures.size();
+    stats.uploadedBytes = uploadedBytes;
+    stats.pendingUploads = 0;
+    for (auto& streamed : textures) {
+        if (streamed.next)
+            stats.pendingUploads++;
+        // the next requests start over
+        streamed.wantedLevel = streamed.initialLevel;
+    }
+    stats.residentBytes = getCommittedBytes();
+    for (const auto& r : retired)
+        stats.residentBytes += r.texture->getMemorySize();
+}
+
+VkDeviceSize MyTextureStreamer::getChainSize(const Streamed& streamed, uint32_t baseLevel) const
+{
+    VkDeviceSize size = 0;
+    for (size_t i = baseLevel; i < streamed.layout.levels.size(); i++)
+        size += streamed.layout.levels[i].size;
+    return size;
+}
+
+VkDeviceSize MyTextureStreamer::getCommittedBytes() const
+{
+    VkDeviceSize bytes = 0;
+    for (const auto& streamed : textures) {
+        bytes += streamed.texture.lock()->getMemorySize();
+        if (streamed.next)
+            bytes += streamed.next->getMemorySize();
+    }
+    return bytes;
+}
+
+bool MyTextureStreamer::startUpload(Streamed& streamed, uint32_t baseLevel)
+{
+    auto next = std::make_unique<MyTexture>(device);
+    try {
+        // only the levels uploaded are read
+        TextureImage image = loadKtx2(streamed.levelPath.c_str(), baseLevel);
+        if (image.width != streamed.layout.width || image.height != streamed.layout.height
+                || image.format != streamed.layout.format
+                || image.levels.size() != streamed.layout.levels.size())
+        {
+            throw std::runtime_error("streamed texture file " + streamed.levelPath + " changed!");
+        }
+        next->recordUpload(image, uploadScheduler, baseLevel);
+    } catch (const std::runtime_error& e) {
+        // keeps what it has, nothing was recorded
+        std::cerr << "failed to stream texture levels: " << e.what() << "\n";
+        return false;
+    }
+    streamed.token = uploadScheduler.getPendingToken();
+    streamed.next = std::move(next);
+    uploadedBytes += getChainSize(streamed, baseLevel);
+    return true;
+}
+
+void MyTextureStreamer::swapIn(Streamed& streamed)
+{
+    std::shared_ptr<MyTexture> texture = streamed.texture.lock();
+    texture->swapResources(*streamed.next);
+    // the spare binding is not used by any frame in flight, the current one may be
+    descriptorManager.writeTextureBinding(streamed.spareBinding, *texture);
+    TextureBinding previous{texture->getDescriptor(), texture->getDescriptorIndex()};
+    texture->setDescriptor(streamed.spareBinding.descriptor, streamed.spareBinding.index,
+            &descriptorManager);
+    streamed.spareBinding = previous;
+    streamed.spareFreeFrame = frame + FRAME_DELAY;
+
+    Retired r;
+    r.texture = std::move(streamed.next);
+    r.frame = frame + FRAME_DELAY;
+    r.token = streamed.token;
+    retired.push_back(std::move(r));
+
+    if (streamed.evicting) {
+        stats.evictions++;
+        stats.totalEvictions++;
+    }
+    else {
+        stats.promotions++;
+        stats.totalPromotions++;
+    }
+}
+
+VkDeviceSize MyTextureStreamer::evict(VkDeviceSize excess)
+{
+    // levels finer than wanted, least recently requested first. Textures
+    // not requested this frame only need their initial levels
+    std::vector<Streamed*> candidates;
+    for (auto& streamed : textures) {
+        if (!streamed.next && streamed.texture.lock()->getBaseLevel() < streamed.wantedLevel)
+            candidates.push_back(&streamed);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Streamed* a, const Streamed* b) {
+        return a->lastRequested < b->lastRequested;
+    });
+
+    VkDeviceSize freed = 0;
+    for (Streamed* streamed : candidates) {
+        if (freed >= excess)
+            break;
+        VkDeviceSize current = streamed->texture.lock()->getMemorySize();
+        VkDeviceSize kept = getChainSize(*streamed, streamed->wantedLevel);
+        if (kept >= current || !startUpload(*streamed, streamed->wantedLevel))
+            continue;
+        streamed->evicting = true;
+        // the old image goes once the replacement is in
+        freed += current - kept;
+    }
+    return std::min(freed, excess);
+}
+
+void MyTextureStreamer::promote(VkDeviceSize committed)
+{
+    // the largest jump in detail first, then the most recently requested
+    std::vector<Streamed*> candidates;
+    for (auto& streamed : textures) {
+        if (!streamed.next && streamed.wantedLevel < streamed.texture.lock()->getBaseLevel())
+            candidates.push_back(&streamed);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Streamed* a, const Streamed* b) {
+        uint32_t gapA = a->texture.lock()->getBaseLevel() - a->wantedLevel;
+        uint32_t gapB = b->texture.lock()->getBaseLevel() - b->wantedLevel;
+        if (gapA != gapB)
+            return gapA > gapB;
+        return a->lastRequested > b->lastRequested;
+    });
+
+    for (Streamed* streamed : candidates) {
+        if (uploadedBytes > 0 && uploadedBytes >= UPLOAD_BYTES_PER_FRAME)
+            break;
+        // both images exist until the swap, take the finest level that fits
+        uint32_t base = streamed->texture.lock()->getBaseLevel();
+        uint32_t level = streamed->wantedLevel;
+        while (level < base && committed + getChainSize(*streamed, level) > budget)
+            level++;
+        if (level == base || !startUpload(*streamed, level))
+            continue;
+        streamed->evicting = false;
+        committed += streamed->next->getMemorySize();
+    }
+}
+
+void MyTextureStreamer::setBudget(VkDeviceSize budget)
+{
+    this->budget = budget;
+}
+
+const TextureStreamingStats& MyTextureStreamer::getStats() const
+{
+    return stats;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "texture.hpp"
+#include "upload_scheduler.hpp"
+#include "descriptor_manager.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+
+class MyDevice;
+class MyDescriptorManager;
+class MyGameObject;
+class MyCamera;
+
+struct TextureStreamingStats
+{
+    VkDeviceSize residentBytes = 0; // replaced images waiting for retirement included
+    VkDeviceSize budget = 0;
+    size_t textures = 0;
+    size_t pendingUploads = 0;      // level changes recorded, batch not completed
+    // last update only
+    size_t promotions = 0;          // textures that got finer levels
+    size_t evictions = 0;           // textures that dropped levels for the budget
+    VkDeviceSize uploadedBytes = 0;
+    // since creation
+    uint64_t totalPromotions = 0;
+    uint64_t totalEvictions = 0;
+};
+
+/* * *
+ * Keeps the resident mip levels of textures to what their objects need on
+ * screen. A texture starts out with its coarse levels only, finer ones are
+ * streamed in as objects using it come close, and textures not needing
+ * their finest levels give them back when the device memory budget runs
+ * out, least recently used first.
+ *
+ * Sparse residency (the optional sparseResidencyImage2D feature) is not
+ * used, our target devices are not required to have it. The levels a
+ * texture holds are the image, so a level change reads the new chain back
+ * from the texture's .ktx2, loose or archived, uploads it into a new image
+ * and swaps it in once the upload completed. Only the level layout stays
+ * in host memory. Every texture owns two texture bindings, sets or
+ * bindless slots, used in turns and the replaced resources are destroyed
+ * once no frame in flight can use them anymore.
+ *
+ * Textures are held weakly, once nothing else owns one it is dropped
+ * together with its spare binding in the next update.
+ */
+class MyTextureStreamer
+{
+public:
+    MyTextureStreamer(MyDevice& device,
+            MyDescriptorManager& descriptorManager,
+            VkDeviceSize budget);
+    ~MyTextureStreamer();
+
+    MyTextureStreamer(const MyTextureStreamer& other) = delete;
+    MyTextureStreamer& operator=(const MyTextureStreamer& other) = delete;
+
+    // the level textures start at and are never evicted past
+    static uint32_t getInitialLevel(const TextureImage& image);
+    // texture has to hold the levels from getInitialLevel(image) down and
+    // its descriptor set, image is what loadKtx2(levelPath) read. Ignored
+    // if its whole chain fits the initial levels
+    void add(const std::shared_ptr<MyTexture>& texture,
+            const TextureImage& image,
+            const std::string& levelPath);
+    bool isStreamed(const MyTexture& texture) const;
+
+    // the finest level each object's texture is useful at, from the size
+    // of the object on screen. Before update, every frame
+    void requestLevels(const std::vector<MyGameObject>& gameObjects,
+            const MyCamera& camera,
+            uint32_t viewportHeight);
+    // main thread, once per frame before recording it
+    void update();
+
+    void setBudget(VkDeviceSize budget);
+    const TextureStreamingStats& getStats() const;
+
+private:
+    struct Streamed
+    {
+        std::weak_ptr<MyTexture> texture;
+        std::string levelPath;
+        TextureImage layout;          // sizes of every level, without pixels
+        TextureBinding spareBinding;
+        uint64_t spareFreeFrame = 0;  // no frame in flight uses the spare binding from here
+        uint32_t initialLevel = 0;
+        uint32_t wantedLevel = 0;     // finest requested since the last update
+        uint64_t lastRequested = 0;
+        // the replacement while its levels upload
+        std::unique_ptr<MyTexture> next;
+        UploadToken token = 0;
+        bool evicting = false;
+    };
+
+    struct Retired
+    {
+        std::unique_ptr<MyTexture> texture;
+        uint64_t frame = 0;     // destroyed from this frame on
+        UploadToken token = 0;  // and once its upload completed
+    };
+
+    // textures nobody else owns anymore
+    void removeExpired();
+    // memory of the levels from baseLevel down, estimated from their data
+    VkDeviceSize getChainSize(const Streamed& streamed, uint32_t baseLevel) const;
+    // textures and their replacements, retired images are on their way out
+    VkDeviceSize getCommittedBytes() const;
+    bool startUpload(Streamed& streamed, uint32_t baseLevel);
+    void swapIn(Streamed& streamed);
+    VkDeviceSize evict(VkDeviceSize excess);
+    void promote(VkDeviceSize committed);
+
+    MyDevice& device;
+    MyDescriptorManager& descriptorManager;
+    MyUploadScheduler& uploadScheduler;
+    VkDeviceSize budget;
+
+    std::vector<Streamed> textures;
+    std::unordered_map<const MyTexture*, size_t> indices;
+    std::vector<Retired> retired;
+    uint64_t frame = 0;
+    VkDeviceSize uploadedBytes = 0; // this update
+    TextureStreamingStats stats;
+};
@@ -0,0 +1,66 @@
+#include "thread_pool.hpp"
+
+//std
+#include <algorithm>
+
+MyThreadPool::MyThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back(&MyThreadPool::workerLoop, this);
+}
+
+MyThreadPool::~MyThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void MyThreadPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+void MyThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    jobsDone.wait(lock, [this]() { return jobs.empty() && running == 0; });
+}
+
+unsigned MyThreadPool::getThreadCount() const
+{
+    return static_cast<unsigned>(workers.size());
+}
+
+void MyThreadPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        if (jobs.empty())
+            return; // stopping and drained
+
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        running++;
+        lock.unlock();
+
+        job();
+
+        lock.lock();
+        running--;
+        if (jobs.empty() && running == 0)
+            jobsDone.notify_all();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+//std
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/* * *
+ * Fixed set of worker threads running queued jobs in submission order.
+ * Jobs must not throw, catch inside the job and hand the error back.
+ * The destructor finishes every queued job before joining.
+ */
+class MyThreadPool
+{
+public:
+    // 0 threads means one per hardware thread
+    MyThreadPool(unsigned threadCount = 0);
+    ~MyThreadPool();
+
+    MyThreadPool(const MyThreadPool& other) = delete;
+    MyThreadPool& operator=(const MyThreadPool& other) = delete;
+
+    void submit(std::function<void()> job);
+    // block until the queue is empty and no job is running
+    void wait();
+
+    unsigned getThreadCount() const;
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobsDone;
+    size_t running = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,313 @@
+#include "upload_scheduler.hpp"
+#include "device.hpp"
+
+//std
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+MyUploadScheduler::MyUploadScheduler(MyDevice& device, VkDeviceSize capacity)
+    : device(device),
+      capacity(capacity)
+{
+    minAlignment = std::max<VkDeviceSize>(
+            device.getProperties().limits.optimalBufferCopyOffsetAlignment, 4);
+
+    device.createBuffer(capacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            ringBuffer,
+            ringMemory,
+            MemoryCategory::Staging);
+    ringData = static_cast<char*>(ringMemory.mapped);
+    recording.token = 1;
+}
+
+MyUploadScheduler::~MyUploadScheduler()
+{
+    waitIdle();
+    for (VkFence fence : freeFences)
+        vkDestroyFence(device.device, fence, nullptr);
+    for (VkSemaphore semaphore : freeSemaphores)
+        vkDestroySemaphore(device.device, semaphore, nullptr);
+    device.destroyBuffer(ringBuffer, ringMemory);
+}
+
+StagingRange MyUploadScheduler::stage(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (size > capacity)
+        return stageDedicated(size);
+
+    alignment = std::max(alignment, minAlignment);
+    while (true) {
+        // nothing in use, start over at the front so any size fits
+        if (head == tail) {
+            head = tail = 0;
+            for (auto& batch : inFlight)
+                batch.ringEnd = 0;
+        }
+
+        uint64_t offset = alignUp(head, alignment);
+        VkDeviceSize ringOffset = offset % capacity;
+        // ranges never wrap, skip the rest of the ring instead
+        if (ringOffset + size > capacity) {
+            offset += capacity - ringOffset;
+            ringOffset = 0;
+        }
+        if (offset + size - tail <= capacity) {
+            head = offset + size;
+            recording.staged = true;
+            stats.copies++;
+            stats.bytes += size;
+
+            StagingRange range;
+            range.buffer = ringBuffer;
+            range.offset = ringOffset;
+            range.data = ringData + ringOffset;
+            return range;
+        }
+
+        if (inFlight.empty()) {
+            // only the batch being recorded holds the space
+            flush();
+            continue;
+        }
+        stats.ringStalls++;
+        vkWaitForFences(device.device, 1, &inFlight.front().fence, VK_TRUE, UINT64_MAX);
+        poll();
+    }
+}
+
+StagingRange MyUploadScheduler::stageDedicated(VkDeviceSize size)
+{
+    VkBuffer buffer;
+    MemoryAllocation memory;
+    device.createBuffer(size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            buffer,
+            memory,
+            MemoryCategory::Staging);
+    void* data = memory.mapped;
+    recording.dedicated.push_back({buffer, memory});
+    recording.staged = true;
+    stats.dedicatedBuffers++;
+    stats.copies++;
+    stats.bytes += size;
+
+    StagingRange range;
+    range.buffer = buffer;
+    range.offset = 0;
+    range.data = data;
+    return range;
+}
+
+void MyUploadScheduler::uploadBuffer(const void* data,
+        VkDeviceSize size,
+        VkBuffer dstBuffer,
+        VkDeviceSize dstOffset)
+{
+    StagingRange staging = stage(size);
+    memcpy(staging.data, data, static_cast<size_t>(size));
+    device.recordCopyBuffer(getTransferCommands(), staging.buffer, dstBuffer, size,
+            staging.offset, dstOffset);
+    device.recordBufferOwnershipTransfer(getTransferCommands(), getGraphicsCommands(),
+            dstBuffer, dstOffset, size,
+            VK_ACCESS_MEMORY_READ_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+}
+
+VkCommandBuffer MyUploadScheduler::getTransferCommands()
+{
+    if (!recording.transferCommands)
+        recording.transferCommands = device.beginSingleCommands(CommandPool::Transfer);
+    return recording.transferCommands;
+}
+
+VkCommandBuffer MyUploadScheduler::getGraphicsCommands()
+{
+    if (!recording.graphicsCommands)
+        recording.graphicsCommands = device.beginSingleCommands(CommandPool::Command);
+    return recording.graphicsCommands;
+}
+
+UploadToken MyUploadScheduler::getPendingToken() const
+{
+    return recording.token;
+}
+
+UploadToken MyUploadScheduler::flush()
+{
+    if (!recording.transferCommands && !recording.graphicsCommands && !recording.staged)
+        return recording.token - 1;
+    // staged without copies still has to retire in order to free its space
+    if (!recording.transferCommands && !recording.graphicsCommands)
+        getTransferCommands();
+
+    Batch batch = std::move(recording);
+    recording = Batch();
+    recording.token = batch.token + 1;
+    batch.ringEnd = head;
+    batch.fence = acquireFence();
+
+    VkSubmitInfo transferSubmit{};
+    transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    VkSubmitInfo graphicsSubmit{};
+    graphicsSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    if (batch.transferCommands) {
+        vkEndCommandBuffer(batch.transferCommands);
+        transferSubmit.commandBufferCount = 1;
+        transferSubmit.pCommandBuffers = &batch.transferCommands;
+    }
+    if (batch.graphicsCommands) {
+        vkEndCommandBuffer(batch.graphicsCommands);
+        graphicsSubmit.commandBufferCount = 1;
+        graphicsSubmit.pCommandBuffers = &batch.graphicsCommands;
+    }
+
+    VkResult result = VK_SUCCESS;
+    if (batch.transferCommands && batch.graphicsCommands) {
+        batch.transferDone = acquireSemaphore();
+        transferSubmit.signalSemaphoreCount = 1;
+        transferSubmit.pSignalSemaphores = &batch.transferDone;
+        graphicsSubmit.waitSemaphoreCount = 1;
+        graphicsSubmit.pWaitSemaphores = &batch.transferDone;
+        graphicsSubmit.pWaitDstStageMask = &waitStage;
+        result = device.queueSubmit(DeviceQueue::Transfer, 1, &transferSubmit, VK_NULL_HANDLE);
+        if (result == VK_SUCCESS)
+            result = device.queueSubmit(DeviceQueue::Graphics, 1, &graphicsSubmit, batch.fence);
+        stats.submissions += 2;
+    }
+    else if (batch.transferCommands) {
+        result = device.queueSubmit(DeviceQueue::Transfer, 1, &transferSubmit, batch.fence);
+        stats.submissions++;
+    }
+    else {
+        result = device.queueSubmit(DeviceQueue::Graphics, 1, &graphicsSubmit, batch.fence);
+        stats.submissions++;
+    }
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("failed to submit upload batch!");
+
+    if (inFlight.empty())
+        busySince = std::chrono::high_resolution_clock::now();
+    stats.batches++;
+    inFlight.push_back(std::move(batch));
+    return inFlight.back().token;
+}
+
+bool MyUploadScheduler::isComplete(UploadToken token)
+{
+    if (token >= recording.token)
+        return false;
+    poll();
+    for (const auto& batch : inFlight) {
+        if (batch.token == token)
+            return batch.done;
+    }
+    return true;
+}
+
+void MyUploadScheduler::wait(UploadToken token)
+{
+    if (token >= recording.token)
+        token = flush();
+    for (auto& batch : inFlight) {
+        if (batch.token == token && !batch.done) {
+            vkWaitForFences(device.device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+            break;
+        }
+    }
+    poll();
+}
+
+void MyUploadScheduler::waitIdle()
+{
+    flush();
+    for (auto& batch : inFlight) {
+        if (!batch.done)
+            vkWaitForFences(device.device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    }
+    poll();
+}
+
+void MyUploadScheduler::poll()
+{
+    for (auto& batch : inFlight) {
+        if (!batch.done && vkGetFenceStatus(device.device, batch.fence) == VK_SUCCESS)
+            batch.done = true;
+    }
+    // transfer only and graphics batches may finish out of order, the ring
+    // is freed in order
+    bool retired = false;
+    while (!inFlight.empty() && inFlight.front().done) {
+        tail = inFlight.front().ringEnd;
+        releaseBatch(inFlight.front());
+        inFlight.pop_front();
+        retired = true;
+    }
+    if (retired && inFlight.empty()) {
+        stats.busySeconds += std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - busySince).count();
+    }
+}
+
+void MyUploadScheduler::releaseBatch(Batch& batch)
+{
+    if (batch.transferCommands)
+        device.recycleSingleCommands(batch.transferCommands);
+    if (batch.graphicsCommands)
+        device.recycleSingleCommands(batch.graphicsCommands);
+    if (batch.transferDone)
+        freeSemaphores.push_back(batch.transferDone);
+    vkResetFences(device.device, 1, &batch.fence);
+    freeFences.push_back(batch.fence);
+    for (auto& [buffer, memory] : batch.dedicated)
+        device.destroyBuffer(buffer, memory);
+}
+
+VkFence MyUploadScheduler::acquireFence()
+{
+    if (!freeFences.empty()) {
+        VkFence fence = freeFences.back();
+        freeFences.pop_back();
+        return fence;
+    }
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence fence;
+    if (vkCreateFence(device.device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload fence!");
+    return fence;
+}
+
+VkSemaphore MyUploadScheduler::acquireSemaphore()
+{
+    if (!freeSemaphores.empty()) {
+        VkSemaphore semaphore = freeSemaphores.back();
+        freeSemaphores.pop_back();
+        return semaphore;
+    }
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device.device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload semaphore!");
+    return semaphore;
+}
+
+UploadSchedulerStats MyUploadScheduler::getStats() const
+{
+    UploadSchedulerStats current = stats;
+    if (!inFlight.empty()) {
+        current.busySeconds += std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - busySince).count();
+    }
+    return current;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "memory_allocator.hpp"
+
+//libs
+#include <vulkan/vulkan.h>
+
+//std
+#include <vector>
+#include <deque>
+#include <utility>
+#include <cstdint>
+#include <chrono>
+
+class MyDevice;
+
+// identifies a batch, increases with every flush
+using UploadToken = uint64_t;
+
+// mapped staging memory, copy from buffer at offset
+struct StagingRange
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    void* data = nullptr;
+};
+
+struct UploadSchedulerStats
+{
+    uint64_t batches = 0;
+    uint64_t submissions = 0;      // vkQueueSubmit calls
+    uint64_t copies = 0;           // staged ranges
+    uint64_t bytes = 0;
+    uint64_t dedicatedBuffers = 0; // ranges too large for the ring
+    uint64_t ringStalls = 0;       // times stage waited on a fence for space
+    double busySeconds = 0.0;      // time with at least one batch in flight
+
+    double bytesPerSecond() const
+    {
+        return busySeconds > 0.0 ? static_cast<double>(bytes) / busySeconds : 0.0;
+    }
+    double submissionsPerBatch() const
+    {
+        return batches ? static_cast<double>(submissions) / batches : 0.0;
+    }
+    double copiesPerBatch() const
+    {
+        return batches ? static_cast<double>(copies) / batches : 0.0;
+    }
+};
+
+/* * *
+ * Staging for every upload. Data is written into one persistently mapped
+ * ring buffer and the copies are recorded into the command buffers of the
+ * current batch, so any number of uploads go out in one submission on
+ * flush. A batch signals a fence instead of idling the queue, its ring
+ * space is reused once that fence has signalled.
+ *
+ * Graphics commands of a batch (mip blits) wait on its transfer commands
+ * through a semaphore. Call stage before fetching the command buffers for
+ * the copies that read from it, a full ring flushes the current batch.
+ */
+class MyUploadScheduler
+{
+public:
+    MyUploadScheduler(MyDevice& device, VkDeviceSize capacity = 64 * 1024 * 1024);
+    ~MyUploadScheduler();
+
+    MyUploadScheduler(const MyUploadScheduler& other) = delete;
+    MyUploadScheduler& operator=(const MyUploadScheduler& other) = delete;
+
+    // valid until the batch it was staged for has completed
+    StagingRange stage(VkDeviceSize size, VkDeviceSize alignment = 16);
+    // stage data and record the copy into dstBuffer
+    void uploadBuffer(const void* data,
+            VkDeviceSize size,
+            VkBuffer dstBuffer,
+            VkDeviceSize dstOffset = 0);
+
+    // command buffers of the batch being recorded, begun on first use
+    VkCommandBuffer getTransferCommands();
+    VkCommandBuffer getGraphicsCommands();
+    // the batch being recorded, completes after the next flush
+    UploadToken getPendingToken() const;
+
+    // submit the batch being recorded and return its token
+    UploadToken flush();
+    bool isComplete(UploadToken token);
+    // flushes first if token is still being recorded
+    void wait(UploadToken token);
+    void waitIdle();
+
+    UploadSchedulerStats getStats() const;
+
+private:
+    struct Batch
+    {
+        UploadToken token = 0;
+        VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+        VkCommandBuffer graphicsCommands = VK_NULL_HANDLE;
+        VkSemaphore transferDone = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        uint64_t ringEnd = 0;
+        std::vector<std::pair<VkBuffer, MemoryAllocation>> dedicated;
+        bool staged = false;
+        bool done = false;
+    };
+
+    void poll();
+    void releaseBatch(Batch& batch);
+    StagingRange stageDedicated(VkDeviceSize size);
+    VkFence acquireFence();
+    VkSemaphore acquireSemaphore();
+
+    MyDevice& device;
+    VkDeviceSize capacity;
+    VkDeviceSize minAlignment = 1;
+    VkBuffer ringBuffer = VK_NULL_HANDLE;
+    MemoryAllocation ringMemory;
+    char* ringData = nullptr;
+    // running byte positions, the ring offset is position % capacity
+    uint64_t head = 0;
+    uint64_t tail = 0;
+
+    Batch recording;
+    std::deque<Batch> inFlight;
+    std::vector<VkFence> freeFences;
+    std::vector<VkSemaphore> freeSemaphores;
+
+    UploadSchedulerStats stats;
+    std::chrono::high_resolution_clock::time_point busySince;
+};
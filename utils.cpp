@@ -1,28 +1,5 @@
 #include <vulkan/vulkan.h>
 
-//std
-#include <vector>
-#include <string>
-#include <fstream>
-
- std::vector<char> readFile(const std::string& filename)
-{
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        throw std::runtime_error("failed to open file!");
-    }
-
-    size_t fileSize = (size_t) file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-
-    file.close();
-    return buffer;
-}
-
 /* * *
  * Proxy function for finding punction pointer of extension.
  */
@@ -42,6 +19,16 @@ VkResult proxyCreateDebugUtilsMessengerEXT(
     }
 }
 
+uint32_t proxyEnumerateInstanceVersion()
+{
+    auto func = (PFN_vkEnumerateInstanceVersion)
+        vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+    uint32_t version = VK_API_VERSION_1_0;
+    if (func != nullptr && func(&version) != VK_SUCCESS)
+        version = VK_API_VERSION_1_0;
+    return version;
+}
+
 void proxyDestroyDebugUtilsMessengerEXT(
         VkInstance instance,
         VkDebugUtilsMessengerEXT debugMessenger,
@@ -3,17 +3,13 @@
 //libs
 #include <vulkan/vulkan.h>
 
-//std
-#include <vector>
-#include <string>
-
-std::vector<char> readFile(const std::string& filename);
-
 VkResult proxyCreateDebugUtilsMessengerEXT(
         VkInstance instance, 
         const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
         const VkAllocationCallbacks* pAllocator,
         VkDebugUtilsMessengerEXT* pDebugMessenger);
+// highest instance version the loader supports, 1.0 loaders lack the query
+uint32_t proxyEnumerateInstanceVersion();
 void proxyDestroyDebugUtilsMessengerEXT(
         VkInstance instance,
         VkDebugUtilsMessengerEXT debugMessenger,
@@ -9,6 +9,10 @@
 //std
 #include <array>
 #include <algorithm>
+#include <vector>
+#include <cstring>
+
+static const uint32_t EMPTY_SLOT = ~0u;
 
 VkVertexInputBindingDescription Vertex::getBindingDescription() 
 {
@@ -44,5 +48,83 @@ std::array<VkVertexInputAttributeDescription, 3>
 
 bool Vertex::operator==(const Vertex& other) const
 {
-    return pos == other.pos && color == other.color && texCoord == other.texCoord;
+    // bitwise like hashVertex, -0 and 0 differ and a NaN equals itself
+    return memcmp(this, &other, sizeof(Vertex)) == 0;
+}
+
+uint64_t hashVertex(const Vertex& vertex)
+{
+    static_assert(sizeof(Vertex) % sizeof(uint64_t) == 0,
+            "vertex hash reads whole 64 bit words");
+    constexpr size_t wordCount = sizeof(Vertex) / sizeof(uint64_t);
+    static const uint64_t secret[8] = {
+        0xbe4ba423396cfeb8, 0x1cad21f72c81017c, 0xdb979083e96dd4de, 0x1f67b3b7a4a44072,
+        0x78e5c0cc4ee679cb, 0x2172ffcc7dd05a82, 0x8e2443f7744608b8, 0x4c263a81e69035e0
+    };
+    static_assert(wordCount <= 8, "vertex larger than the hash secret");
+
+    uint64_t words[wordCount];
+    memcpy(words, &vertex, sizeof(Vertex));
+
+    // independent multiply-fold per word, the loop vectorizes
+    uint64_t acc = sizeof(Vertex) * 0x9e3779b185ebca87;
+    for (size_t i = 0; i < wordCount; i++) {
+        uint64_t w = words[i] ^ secret[i];
+        acc += (w & 0xffffffff) * (w >> 32);
+    }
+
+    acc ^= acc >> 37;
+    acc *= 0x165667919e3779f9;
+    acc ^= acc >> 32;
+    return acc;
+}
+
+static size_t tableCapacity(size_t maxVertices)
+{
+    // keep the load factor at or below one half
+    size_t capacity = 16;
+    while (capacity < maxVertices * 2)
+        capacity <<= 1;
+    return capacity;
+}
+
+MyVertexDedupTable::MyVertexDedupTable(size_t maxVertices)
+    : slots(tableCapacity(maxVertices), EMPTY_SLOT),
+      mask(tableCapacity(maxVertices) - 1)
+{ }
+
+uint32_t MyVertexDedupTable::insert(const Vertex& vertex, std::vector<Vertex>& vertices)
+{
+    if ((count + 1) * 2 > slots.size())
+        grow(vertices);
+
+    size_t slot = hashVertex(vertex) & mask;
+    while (slots[slot] != EMPTY_SLOT) {
+        uint32_t index = slots[slot];
+        if (memcmp(&vertices[index], &vertex, sizeof(Vertex)) == 0)
+            return index;
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t index = static_cast<uint32_t>(vertices.size());
+    slots[slot] = index;
+    vertices.push_back(vertex);
+    count++;
+    return index;
+}
+
+void MyVertexDedupTable::grow(const std::vector<Vertex>& vertices)
+{
+    std::vector<uint32_t> oldSlots(slots.size() * 2, EMPTY_SLOT);
+    std::swap(slots, oldSlots);
+    mask = slots.size() - 1;
+
+    for (uint32_t index : oldSlots) {
+        if (index == EMPTY_SLOT)
+            continue;
+        size_t slot = hashVertex(vertices[index]) & mask;
+        while (slots[slot] != EMPTY_SLOT)
+            slot = (slot + 1) & mask;
+        slots[slot] = index;
+    }
 }
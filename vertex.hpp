@@ -9,6 +9,9 @@
 //std
 #include <array>
 #include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
 
 struct Vertex {
     glm::vec3 pos;
@@ -20,15 +23,38 @@ struct Vertex {
     static std::array<VkVertexInputAttributeDescription, 3>
         getAttributeDescriptions();
 
+    // bitwise, consistent with hashVertex
     bool operator==(const Vertex& other) const;
 };
 
+// hash over the raw bytes of the vertex, bytewise equal vertices hash equal
+uint64_t hashVertex(const Vertex& vertex);
+
+/* * *
+ * Flat open-addressing table for deduplicating vertices while building an
+ * index buffer. Slots hold indices into the caller's vertex array, so the
+ * table itself is a single allocation sized up front.
+ */
+class MyVertexDedupTable
+{
+public:
+    MyVertexDedupTable(size_t maxVertices);
+
+    // index of an equal vertex in vertices, appending it if there is none
+    uint32_t insert(const Vertex& vertex, std::vector<Vertex>& vertices);
+
+private:
+    void grow(const std::vector<Vertex>& vertices);
+
+    std::vector<uint32_t> slots;
+    size_t mask;
+    size_t count = 0;
+};
+
 namespace std {
     template<> struct hash<Vertex> {
         size_t operator()(Vertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^
-                   (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
-                   (hash<glm::vec2>()(vertex.texCoord) << 1);
+            return static_cast<size_t>(hashVertex(vertex));
         }
     };
 }